@@ -0,0 +1,84 @@
+#ifndef ADDRESS_PLANNER_H
+#define ADDRESS_PLANNER_H
+
+// Integer address plan for point-to-point links: link i gets the i-th /30 (or
+// /31, RFC 3021) subnet of a pool such as 10.0.0.0/8, side a takes its first
+// usable address and side b the next one. Every address, subnet and the
+// reverse lookup from an address back to link * 2 + side are plain arithmetic,
+// so the plan costs nothing per link and answers lookups in constant time at
+// any size (a /8 holds about four million /30 links). Plain C++, no ns-3;
+// addresses are host-order uint32_t as Ipv4Address::Get() returns them.
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+class AddressPlanner {
+public:
+    static constexpr uint32_t kNone = 0xffffffff;
+
+    // poolPrefix must be at least 2 and below linkPrefix; linkPrefix 30 or 31
+    explicit AddressPlanner(uint32_t poolBase = 10u << 24, uint32_t poolPrefix = 8, uint32_t linkPrefix = 30)
+        : m_shift(32 - linkPrefix),
+          m_first(linkPrefix == 31 ? 0 : 1),
+          m_poolBits(32 - poolPrefix),
+          m_base(poolBase & ~((uint64_t(1) << m_poolBits) - 1)) {}
+
+    // Reads "a.b.c.d/len"; false if it is not one
+    static bool ParsePool(const std::string& cidr, uint32_t& base, uint32_t& prefix) {
+        std::istringstream in(cidr);
+        uint32_t octet[4];
+        char dot[3];
+        char slash;
+        if (!(in >> octet[0] >> dot[0] >> octet[1] >> dot[1] >> octet[2] >> dot[2] >> octet[3] >> slash >> prefix) ||
+            dot[0] != '.' || dot[1] != '.' || dot[2] != '.' || slash != '/' || prefix > 32) {
+            return false;
+        }
+        base = 0;
+        for (uint32_t o : octet) {
+            if (o > 255) {
+                return false;
+            }
+            base = (base << 8) | o;
+        }
+        return true;
+    }
+
+    // Number of links the pool holds
+    uint64_t Capacity() const { return uint64_t(1) << (m_poolBits - m_shift); }
+
+    uint32_t Mask() const { return ~((uint32_t(1) << m_shift) - 1); }
+
+    uint32_t Subnet(uint32_t link) const { return m_base + (link << m_shift); }
+
+    // Address of side 0 (a) or 1 (b) of 'link'
+    uint32_t Address(uint32_t link, uint32_t side) const { return Subnet(link) + m_first + side; }
+
+    // link * 2 + side of the interface that owns 'address', kNone if no planned
+    // interface can have it
+    uint32_t InterfaceOf(uint32_t address) const {
+        uint32_t offset = address - m_base;
+        if (uint64_t(offset) >> m_poolBits) {
+            return kNone;
+        }
+        uint32_t side = (offset & ~Mask()) - m_first;
+        return side < 2 ? (offset >> m_shift) * 2 + side : kNone;
+    }
+
+    // The link whose subnet is dest/mask, kNone if it is not a link subnet
+    uint32_t LinkOfSubnet(uint32_t dest, uint32_t mask) const {
+        uint32_t offset = dest - m_base;
+        if (mask != Mask() || (uint64_t(offset) >> m_poolBits) || (offset & ~mask)) {
+            return kNone;
+        }
+        return offset >> m_shift;
+    }
+
+private:
+    uint32_t m_shift;     // host bits of a link subnet
+    uint32_t m_first;     // offset of side a inside its subnet
+    uint32_t m_poolBits;  // host bits of the pool
+    uint32_t m_base;
+};
+
+#endif // ADDRESS_PLANNER_H
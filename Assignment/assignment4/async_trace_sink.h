@@ -0,0 +1,127 @@
+#ifndef ASYNC_TRACE_SINK_H
+#define ASYNC_TRACE_SINK_H
+
+// Moves trace output off the simulator thread. Callbacks Push() fixed-size
+// records into a bounded single-producer/single-consumer ring; a writer thread
+// pops them in batches and hands them to a handler that formats and writes.
+
+#include "ns3/simulator.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Lock-free ring for exactly one producer and one consumer thread. Capacity is
+// rounded up to a power of two; one slot is never used so full != empty.
+template <typename Record>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity + 1) {
+            size <<= 1;
+        }
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    bool TryPush(const Record& record) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t next = (head + 1) & m_mask;
+        if (next == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        m_slots[head] = record;
+        m_head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Pops up to 'max' records into 'out'; returns how many were popped.
+    size_t PopBatch(Record* out, size_t max) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t head = m_head.load(std::memory_order_acquire);
+        size_t n = 0;
+        while (tail != head && n < max) {
+            out[n++] = m_slots[tail];
+            tail = (tail + 1) & m_mask;
+        }
+        m_tail.store(tail, std::memory_order_release);
+        return n;
+    }
+
+private:
+    std::vector<Record> m_slots;
+    size_t m_mask;
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+template <typename Record>
+class AsyncTraceSink {
+public:
+    // Called on the writer thread with a batch of records in push order.
+    typedef std::function<void(const Record*, size_t)> Handler;
+
+    explicit AsyncTraceSink(size_t capacity = 1 << 16) : m_ring(capacity) {}
+
+    ~AsyncTraceSink() { Stop(); }
+
+    void Start(Handler handler, size_t batchSize = 1024) {
+        m_handler = handler;
+        m_batchSize = batchSize;
+        m_running.store(true, std::memory_order_release);
+        m_thread = std::thread(&AsyncTraceSink::Run, this);
+    }
+
+    // Makes Simulator::Destroy() drain the ring and join the writer, so no
+    // record is lost even if main() never calls Stop().
+    void StopOnDestroy() {
+        ns3::Simulator::ScheduleDestroy(&AsyncTraceSink::Stop, this);
+    }
+
+    // Never drops a record: if the writer falls a full ring behind, the
+    // simulator waits for it, which keeps memory bounded by the capacity.
+    void Push(const Record& record) {
+        while (!m_ring.TryPush(record)) {
+            ++m_stalls;
+            std::this_thread::yield();
+        }
+    }
+
+    void Stop() {
+        if (m_thread.joinable()) {
+            m_running.store(false, std::memory_order_release);
+            m_thread.join();
+        }
+    }
+
+    // Number of times Push() found the ring full
+    uint64_t GetStalls() const { return m_stalls; }
+
+private:
+    void Run() {
+        std::vector<Record> batch(m_batchSize);
+        while (true) {
+            bool running = m_running.load(std::memory_order_acquire);
+            size_t n = m_ring.PopBatch(batch.data(), batch.size());
+            if (n > 0) {
+                m_handler(batch.data(), n);
+            } else if (!running) {
+                break; // stopped and fully drained
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+    }
+
+    SpscRing<Record> m_ring;
+    Handler m_handler;
+    size_t m_batchSize = 1024;
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+    uint64_t m_stalls = 0;
+};
+
+#endif // ASYNC_TRACE_SINK_H
@@ -0,0 +1,345 @@
+// Benchmark driver for the assignment4 experiments. Runs the drop, delay,
+// queue and path experiments over a grid of host counts x offered load x
+// trace verbosity, each with --Profile, and collects wall time, events/s and
+// peak memory into one table:
+//
+//   ./benchmark_runner --hosts=7,70,700 --load=100 --repeats=3 --out=bench
+//
+// writes bench/benchmark.csv with one row per run. 7 hosts is the built-in
+// A-G network; any other count is a generated router grid with one host per
+// router, as close to square as the count allows. Load is packets/s sent by
+// each host, so the offered total grows linearly with the host count: drop
+// and delay send to the next min(6, N-1) hosts (--Peers, all pairs at 7
+// hosts) at load/peers each, and queue and path have every host echo with
+// the host half way round (--EchoPairs) at load. Trace verbosity is "quiet"
+// (no packet logging, no binary traces, queues sampled every second) or
+// "full" (everything on).
+//
+// With --baseline=<old benchmark.csv> the averages over the repeats of every
+// configuration are compared with the baseline's; comparison.csv gets one row
+// per configuration and the exit code is 2 when any run lost more than
+// --tolerance of its events/s or grew its peak memory by more than that.
+//
+// Runs are serial by default (--jobs=1) so they do not compete for cores and
+// memory bandwidth; --command works as in sweep_runner.
+#include "process_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+struct BenchmarkPoint {
+    std::string experiment;
+    uint32_t hosts;
+    std::string load;
+    std::string trace;
+    uint32_t repeat;
+    std::string outputDir;
+};
+
+// What a run's "profile key=value ..." line reported, plus the process wall
+// time seen from outside
+struct BenchmarkSample {
+    double processWall = 0;
+    std::map<std::string, std::string> profile;
+};
+
+static const char* kProfileKeys[] = {"events",      "wall_s",   "sim_s",  "events_per_s", "sim_wall_ratio",
+                                     "peak_rss_kb", "app_send", "p2p_tx", "queue",        "flowmon_probe",
+                                     "trace_callbacks"};
+
+static std::vector<std::string> SplitList(const std::string& text, char separator = ',') {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, separator)) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static std::string ReplaceAll(std::string text, const std::string& from, const std::string& to) {
+    for (size_t pos = text.find(from); pos != std::string::npos; pos = text.find(from, pos + to.size())) {
+        text.replace(pos, from.size(), to);
+    }
+    return text;
+}
+
+// --Topology for 'hosts' hosts: none for the built-in network, otherwise a
+// width x height router grid (one host each) with width the largest divisor
+// of 'hosts' not above its square root
+static std::string TopologyFor(uint32_t hosts) {
+    if (hosts == 7) {
+        return "";
+    }
+    uint32_t width = 1;
+    for (uint32_t w = 1; w * w <= hosts; ++w) {
+        if (hosts % w == 0) {
+            width = w;
+        }
+    }
+    return "grid:width=" + std::to_string(width) + ",height=" + std::to_string(hosts / width) + ",hosts=1";
+}
+
+// Experiment name -> program, and the program options of a verbosity
+static std::string ProgramFor(const std::string& experiment) {
+    static const std::map<std::string, std::string> programs = {
+        {"drop", "packet_drop"}, {"delay", "end_to_end_delay"}, {"queue", "queue_length"}, {"path", "tracking_path"}};
+    auto it = programs.find(experiment);
+    return it == programs.end() ? experiment : it->second;
+}
+
+// Traffic options for 'load' packets/s per host, kept up until 'stopTime'
+static std::string LoadArgs(const std::string& program, uint32_t hosts, double load, double stopTime) {
+    uint32_t peers = 1;
+    std::string args;
+    if (program == "packet_drop" || program == "end_to_end_delay") {
+        peers = std::max<uint32_t>(1, std::min<uint32_t>(6, hosts - 1));
+        args += " --Peers=" + std::to_string(peers);
+    } else if (program == "queue_length" || program == "tracking_path") {
+        args += " --EchoPairs=true";
+    }
+    double interval = peers / load;
+    std::ostringstream value;
+    value << std::setprecision(9) << interval;
+    args += " --Interval=" + value.str() + " --MaxPackets=" + std::to_string(uint64_t(std::ceil(stopTime / interval)));
+    return args;
+}
+
+static std::string TraceArgs(const std::string& program, const std::string& trace) {
+    bool full = trace == "full";
+    std::string args = std::string(" --LogPackets=") + (full ? "true" : "false");
+    if (program == "tracking_path") {
+        args += std::string(" --WriteTraces=") + (full ? "true" : "false");
+    } else if (program == "queue_length") {
+        args += std::string(" --SampleInterval=") + (full ? "0" : "1");
+    }
+    return args;
+}
+
+// The last "profile ..." line of a run log
+static bool ReadProfile(const std::string& logPath, BenchmarkSample& sample) {
+    std::ifstream log(logPath);
+    std::string line;
+    std::string last;
+    while (std::getline(log, line)) {
+        if (line.compare(0, 8, "profile ") == 0) {
+            last = line;
+        }
+    }
+    if (last.empty()) {
+        return false;
+    }
+    for (const auto& field : SplitList(last.substr(8), ' ')) {
+        size_t eq = field.find('=');
+        if (eq != std::string::npos) {
+            sample.profile[field.substr(0, eq)] = field.substr(eq + 1);
+        }
+    }
+    return true;
+}
+
+using ConfigKey = std::tuple<std::string, std::string, std::string, std::string>;   // experiment, hosts, load, trace
+
+struct ConfigAverage {
+    double wall = 0;
+    double eventsPerSecond = 0;
+    double rssKb = 0;
+    uint32_t runs = 0;
+};
+
+// Averages per configuration of a benchmark.csv (failed runs skipped)
+static std::map<ConfigKey, ConfigAverage> ReadAverages(const std::string& path) {
+    std::map<ConfigKey, ConfigAverage> averages;
+    std::ifstream csv(path);
+    std::string line;
+    if (!std::getline(csv, line)) {
+        return averages;
+    }
+    std::vector<std::string> header = SplitList(line);
+    std::map<std::string, size_t> column;
+    for (size_t i = 0; i < header.size(); ++i) {
+        column[header[i]] = i;
+    }
+    for (const char* name : {"experiment", "hosts", "load", "trace", "exit_code", "process_wall_s",
+                             "events_per_s", "peak_rss_kb"}) {
+        if (!column.count(name)) {
+            std::cerr << "Error: " << path << " has no " << name << " column" << std::endl;
+            return {};
+        }
+    }
+    while (std::getline(csv, line)) {
+        std::vector<std::string> fields = SplitList(line);
+        if (fields.size() != header.size() || fields[column["exit_code"]] != "0") {
+            continue;
+        }
+        ConfigAverage& a = averages[ConfigKey(fields[column["experiment"]], fields[column["hosts"]],
+                                              fields[column["load"]], fields[column["trace"]])];
+        ++a.runs;
+        a.wall += (std::stod(fields[column["process_wall_s"]]) - a.wall) / a.runs;
+        a.eventsPerSecond += (std::stod(fields[column["events_per_s"]]) - a.eventsPerSecond) / a.runs;
+        a.rssKb += (std::stod(fields[column["peak_rss_kb"]]) - a.rssKb) / a.runs;
+    }
+    return averages;
+}
+
+// Prints and writes the baseline comparison; returns the number of regressions
+static uint32_t Compare(const std::map<ConfigKey, ConfigAverage>& baseline,
+                        const std::map<ConfigKey, ConfigAverage>& current, double tolerance,
+                        const std::filesystem::path& csvPath) {
+    std::ofstream csv(csvPath);
+    csv << "experiment,hosts,load,trace,baseline_wall_s,wall_s,baseline_events_per_s,events_per_s,"
+           "throughput_ratio,baseline_peak_rss_kb,peak_rss_kb,memory_ratio,verdict\n";
+    std::cout << std::left << std::setw(40) << "configuration" << std::right << std::setw(12) << "wall"
+              << std::setw(12) << "events/s" << std::setw(12) << "memory" << "  (current / baseline)" << std::endl;
+    uint32_t regressions = 0;
+    for (const auto& entry : current) {
+        auto base = baseline.find(entry.first);
+        if (base == baseline.end()) {
+            continue;
+        }
+        const ConfigAverage& b = base->second;
+        const ConfigAverage& c = entry.second;
+        double throughput = b.eventsPerSecond > 0 ? c.eventsPerSecond / b.eventsPerSecond : 0;
+        double memory = b.rssKb > 0 ? c.rssKb / b.rssKb : 0;
+        std::string verdict = throughput < 1 - tolerance || memory > 1 + tolerance ? "regression"
+                              : throughput > 1 + tolerance                         ? "faster"
+                                                                                   : "same";
+        regressions += verdict == "regression";
+        std::string name = std::get<0>(entry.first) + " hosts=" + std::get<1>(entry.first) +
+                           " load=" + std::get<2>(entry.first) + " " + std::get<3>(entry.first);
+        std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << (b.wall > 0 ? c.wall / b.wall : 0) << std::setw(12) << throughput
+                  << std::setw(12) << memory << "  " << verdict << std::endl;
+        csv << std::get<0>(entry.first) << "," << std::get<1>(entry.first) << "," << std::get<2>(entry.first)
+            << "," << std::get<3>(entry.first) << "," << b.wall << "," << c.wall << "," << b.eventsPerSecond
+            << "," << c.eventsPerSecond << "," << throughput << "," << b.rssKb << "," << c.rssKb << ","
+            << memory << "," << verdict << "\n";
+    }
+    return regressions;
+}
+
+int main(int argc, char *argv[]) {
+    std::map<std::string, std::string> options = {
+        {"experiments", "drop,delay,queue,path"},
+        {"hosts", "7,70,700,7000"},
+        {"load", "100"},
+        {"trace", "quiet,full"},
+        {"StopTime", "10"},
+        {"repeats", "1"},
+        {"jobs", "1"},
+        {"out", "benchmark"},
+        {"baseline", ""},
+        {"tolerance", "0.05"},
+        {"command", "./ns3 run --no-build \"{exp} {args}\""},
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos || !options.count(arg.substr(2, eq - 2))) {
+            std::cerr << "Usage: " << argv[0] << " [--name=value ...]; known options:" << std::endl;
+            for (const auto& option : options) {
+                std::cerr << "  --" << option.first << " (default " << option.second << ")" << std::endl;
+            }
+            return 1;
+        }
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+
+    std::filesystem::path outDir = std::filesystem::absolute(options["out"]);
+    // The run directories go into the command line, inside the double quotes
+    // of the default ns3 template
+    if (!SafeInDoubleQuotes(outDir.string())) {
+        std::cerr << "Error: --out path " << outDir << " must not contain $, `, \" or \\" << std::endl;
+        return 1;
+    }
+    std::vector<BenchmarkPoint> points;
+    uint32_t repeats = std::stoul(options["repeats"]);
+    for (const auto& experiment : SplitList(options["experiments"])) {
+        for (const auto& hosts : SplitList(options["hosts"])) {
+            for (const auto& load : SplitList(options["load"])) {
+                for (const auto& trace : SplitList(options["trace"])) {
+                    for (uint32_t repeat = 1; repeat <= repeats; ++repeat) {
+                        BenchmarkPoint point{experiment, uint32_t(std::stoul(hosts)), load, trace, repeat, ""};
+                        point.outputDir = (outDir / (std::to_string(points.size()) + "-" + experiment)).string();
+                        points.push_back(point);
+                    }
+                }
+            }
+        }
+    }
+
+    ProcessPool pool(std::stoul(options["jobs"]));
+    for (const auto& point : points) {
+        std::filesystem::create_directories(point.outputDir);
+        std::string program = ProgramFor(point.experiment);
+        std::string topology = TopologyFor(point.hosts);
+        std::string args = "--Profile=true --StopTime=" + options["StopTime"] +
+                           " --OutputDir=" + ShellQuote(point.outputDir) +
+                           LoadArgs(program, point.hosts, std::stod(point.load), std::stod(options["StopTime"])) +
+                           TraceArgs(program, point.trace) + (topology.empty() ? "" : " --Topology=" + topology);
+        std::string command = ReplaceAll(ReplaceAll(options["command"], "{exp}", program), "{args}", args);
+        pool.Add(command + " > " + ShellQuote(point.outputDir + "/run.log") + " 2>&1");
+    }
+
+    std::cout << "Running " << points.size() << " benchmarks on " << options["jobs"] << " workers" << std::endl;
+    size_t done = 0;
+    std::vector<ProcessResult> results = pool.Run([&done, &points](const ProcessResult& result) {
+        ++done;
+        const BenchmarkPoint& point = points[result.id];
+        std::cout << "[" << done << "/" << points.size() << "] " << point.experiment << " hosts=" << point.hosts
+                  << " load=" << point.load << " " << point.trace << (result.exitCode == 0 ? " ok " : " FAILED ")
+                  << result.wallSeconds << "s" << std::endl;
+    });
+
+    std::filesystem::path tablePath = outDir / "benchmark.csv";
+    std::ofstream table(tablePath);
+    table << "experiment,hosts,load,trace,repeat,exit_code,process_wall_s";
+    for (const char* key : kProfileKeys) {
+        table << "," << key;
+    }
+    table << "\n";
+    uint32_t failures = 0;
+    for (const auto& result : results) {
+        const BenchmarkPoint& point = points[result.id];
+        BenchmarkSample sample;
+        sample.processWall = result.wallSeconds;
+        int exitCode = result.exitCode;
+        if (exitCode != 0 || !ReadProfile(point.outputDir + "/run.log", sample)) {
+            std::cerr << "Error: no profile from " << point.outputDir << " (see run.log)" << std::endl;
+            exitCode = exitCode == 0 ? -1 : exitCode;
+            ++failures;
+        }
+        table << point.experiment << "," << point.hosts << "," << point.load << "," << point.trace << ","
+              << point.repeat << "," << exitCode << "," << sample.processWall;
+        for (const char* key : kProfileKeys) {
+            auto it = sample.profile.find(key);
+            table << "," << (it == sample.profile.end() ? "" : it->second);
+        }
+        table << "\n";
+    }
+    table.close();
+    std::cout << "Wrote " << results.size() << " runs to " << tablePath.string() << std::endl;
+
+    if (options["baseline"].empty()) {
+        return failures == 0 ? 0 : 1;
+    }
+    std::map<ConfigKey, ConfigAverage> baseline = ReadAverages(options["baseline"]);
+    if (baseline.empty()) {
+        std::cerr << "Error: no usable runs in baseline " << options["baseline"] << std::endl;
+        return 1;
+    }
+    uint32_t regressions = Compare(baseline, ReadAverages(tablePath.string()), std::stod(options["tolerance"]),
+                                   outDir / "comparison.csv");
+    std::cout << regressions << " regression(s) against " << options["baseline"] << std::endl;
+    return regressions ? 2 : failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+#ifndef COUNTER_RNG_H
+#define COUNTER_RNG_H
+
+// Counter-based random numbers: every draw is a pure function of
+// (seed, run, stream, counter), so a value can be computed on its own, in any
+// order or on any thread, and still match every other run with the same key.
+// The mixing is SplitMix64's finalizer applied to the key words in turn.
+// Plain C++, no ns-3; callers take seed and run from RngSeedManager.
+
+#include <cmath>
+#include <cstdint>
+
+class CounterRng {
+public:
+    CounterRng(uint64_t seed, uint64_t run, uint64_t stream)
+        : m_key(Mix(Mix(Mix(seed) ^ run) ^ stream)) {}
+
+    // 64 random bits for draw number 'counter'
+    uint64_t Bits(uint64_t counter) const { return Mix(m_key ^ Mix(counter)); }
+
+    // Uniform in [0, 1), 53-bit resolution
+    double Uniform(uint64_t counter) const { return (Bits(counter) >> 11) * 0x1.0p-53; }
+
+    // Poisson(mean) for draw 'counter', by inversion with sub-draws taken from
+    // counter's own sequence. Means above 30 are split into chunks of at most
+    // 30 and summed, which keeps exp(-chunk) well away from underflow.
+    uint32_t Poisson(uint64_t counter, double mean) const {
+        CounterRng sub(m_key, counter, 0);
+        uint64_t draw = 0;
+        uint32_t total = 0;
+        while (mean > 0) {
+            double chunk = mean > 30.0 ? 30.0 : mean;
+            mean -= chunk;
+            double p = std::exp(-chunk);
+            double cdf = p;
+            double u = sub.Uniform(draw++);
+            uint32_t k = 0;
+            while (u > cdf && p > 0) {
+                ++k;
+                p *= chunk / k;
+                cdf += p;
+            }
+            total += k;
+        }
+        return total;
+    }
+
+private:
+    static uint64_t Mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    uint64_t m_key;
+};
+
+#endif // COUNTER_RNG_H
@@ -0,0 +1,194 @@
+#ifndef DELAY_PROBE_H
+#define DELAY_PROBE_H
+
+// One-way delay per (source host, destination host), updated as each packet
+// reaches its PacketSink. The matrix senders stamp every packet with a
+// SeqTsSizeHeader, so the delay is known on receipt and nothing is kept per
+// packet: memory is one RunningStats (and optional Histogram) per host pair.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "distributed.h"
+#include "run_profiler.h"
+#include "running_stats.h"
+#include "topology_builder.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+class DelayProbe {
+public:
+    // A histogram of 'histogramBins' buckets of 'histogramBinSeconds' is kept
+    // per pair when both are non-zero.
+    explicit DelayProbe(const Topology& topo, double histogramBinSeconds = 0, uint32_t histogramBins = 0)
+        : m_names(topo.names.begin(), topo.names.begin() + topo.GetNHosts()),
+          m_n(topo.GetNHosts()),
+          m_stats(m_n * m_n) {
+        for (uint32_t i = 0; i < m_n; ++i) {
+            m_hostByAddress[topo.HostAddress(i).Get()] = i;
+        }
+        if (histogramBinSeconds > 0 && histogramBins > 0) {
+            m_histograms.assign(m_n * m_n, Histogram(histogramBinSeconds, histogramBins));
+        }
+        // One connection per destination host, with its index bound in
+        for (uint32_t i = 0; i < m_n; ++i) {
+            std::ostringstream path;
+            path << "/NodeList/" << topo.hosts.Get(i)->GetId()
+                 << "/ApplicationList/*/$ns3::PacketSink/RxWithSeqTsSize";
+            Config::ConnectWithoutContext(path.str(), MakeBoundCallback(&DelayProbe::Receive, this, i));
+        }
+    }
+
+    const RunningStats& Get(uint32_t src, uint32_t dst) const { return m_stats[src * m_n + dst]; }
+
+    // Merges the statistics of all ranks of a distributed run into rank 0's
+    // (each pair is only seen on its destination's rank); a no-op in a
+    // single process
+    void MergeRanks() {
+        MergeStatsToRoot(m_stats);
+        if (m_histograms.empty()) {
+            return;
+        }
+        size_t bins = m_histograms[0].counts.size();
+        std::vector<uint64_t> counts(m_histograms.size() * bins);
+        for (size_t i = 0; i < m_histograms.size(); ++i) {
+            std::copy(m_histograms[i].counts.begin(), m_histograms[i].counts.end(), counts.begin() + i * bins);
+        }
+        ReduceToRoot(counts.data(), counts.size());
+        for (size_t i = 0; i < m_histograms.size(); ++i) {
+            std::copy(counts.begin() + i * bins, counts.begin() + (i + 1) * bins, m_histograms[i].counts.begin());
+        }
+    }
+
+    // The raw per-pair statistics and histogram counts, and merging such a
+    // dump from another process's run of the same topology (see
+    // forked_partitions.h)
+    void Save(std::ostream& os) const {
+        os.write(reinterpret_cast<const char*>(m_stats.data()), m_stats.size() * sizeof(RunningStats));
+        for (const Histogram& h : m_histograms) {
+            os.write(reinterpret_cast<const char*>(h.counts.data()), h.counts.size() * sizeof(uint64_t));
+        }
+    }
+
+    bool MergeFrom(std::istream& is) {
+        std::vector<RunningStats> stats(m_stats.size());
+        if (!is.read(reinterpret_cast<char*>(stats.data()), stats.size() * sizeof(RunningStats))) {
+            return false;
+        }
+        for (size_t i = 0; i < stats.size(); ++i) {
+            m_stats[i].Merge(stats[i]);
+        }
+        std::vector<uint64_t> counts;
+        for (Histogram& h : m_histograms) {
+            counts.resize(h.counts.size());
+            if (!is.read(reinterpret_cast<char*>(counts.data()), counts.size() * sizeof(uint64_t))) {
+                return false;
+            }
+            for (size_t b = 0; b < counts.size(); ++b) {
+                h.counts[b] += counts[b];
+            }
+        }
+        return true;
+    }
+
+    // Mean and variance matrices in the delay_calculation.txt layout
+    void WriteText(std::ostream& os) const {
+        os << std::fixed << std::setprecision(6);
+        WriteMatrix(os, "Average End-to-End Delays (seconds):", [](const RunningStats& s) { return s.mean; });
+        os << "\n";
+        WriteMatrix(os, "Variance of Delays (seconds):", [](const RunningStats& s) { return s.Variance(); });
+    }
+
+    bool WriteCsv(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << std::setprecision(9) << "src,dst,mean_delay,delay_variance,min_delay,max_delay,received\n";
+        for (uint32_t i = 0; i < m_n; ++i) {
+            for (uint32_t j = 0; j < m_n; ++j) {
+                if (i != j) {
+                    const RunningStats& s = Get(i, j);
+                    file << m_names[i] << "," << m_names[j] << "," << s.mean << "," << s.Variance() << ","
+                         << (s.count ? s.min : 0.0) << "," << (s.count ? s.max : 0.0) << "," << s.count << "\n";
+                }
+            }
+        }
+        return file.good();
+    }
+
+    // "src,dst,bin_start,count" for every non-empty bucket
+    bool WriteHistogramCsv(const std::string& path) const {
+        if (m_histograms.empty()) {
+            return true;
+        }
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << std::setprecision(9) << "src,dst,bin_start,count\n";
+        for (uint32_t i = 0; i < m_n; ++i) {
+            for (uint32_t j = 0; j < m_n; ++j) {
+                const Histogram& h = m_histograms[i * m_n + j];
+                for (size_t b = 0; b < h.counts.size(); ++b) {
+                    if (h.counts[b]) {
+                        file << m_names[i] << "," << m_names[j] << "," << b * h.binWidth << "," << h.counts[b]
+                             << "\n";
+                    }
+                }
+            }
+        }
+        return file.good();
+    }
+
+private:
+    static void Receive(DelayProbe* probe, uint32_t dst, Ptr<const Packet> packet, const Address& from,
+                        const Address& to, const SeqTsSizeHeader& header) {
+        ++TraceCallbackCount();
+        if (!InetSocketAddress::IsMatchingType(from)) {
+            return;
+        }
+        auto src = probe->m_hostByAddress.find(InetSocketAddress::ConvertFrom(from).GetIpv4().Get());
+        if (src == probe->m_hostByAddress.end()) {
+            return;
+        }
+        double delay = (Simulator::Now() - header.GetTs()).GetSeconds();
+        uint32_t pair = src->second * probe->m_n + dst;
+        probe->m_stats[pair].Add(delay);
+        if (!probe->m_histograms.empty()) {
+            probe->m_histograms[pair].Add(delay);
+        }
+    }
+
+    template <typename Value>
+    void WriteMatrix(std::ostream& os, const std::string& title, Value value) const {
+        os << title << std::endl;
+        os << "To:  ";
+        for (const auto& name : m_names) {
+            os << std::setw(9) << name << "   ";
+        }
+        os << std::endl;
+        for (uint32_t i = 0; i < m_n; ++i) {
+            os << m_names[i] << "   ";
+            for (uint32_t j = 0; j < m_n; ++j) {
+                os << value(Get(i, j)) << "    ";
+            }
+            os << std::endl;
+        }
+    }
+
+    std::vector<std::string> m_names;
+    uint32_t m_n;
+    std::unordered_map<uint32_t, uint32_t> m_hostByAddress;
+    std::vector<RunningStats> m_stats;
+    std::vector<Histogram> m_histograms;
+};
+
+#endif // DELAY_PROBE_H
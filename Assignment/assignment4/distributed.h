@@ -0,0 +1,219 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+// Distributed runs over MPI with ns-3's DistributedSimulatorImpl. Every rank
+// builds the whole topology, but each node belongs to one rank (its system
+// id) and only that rank runs its events; links between ranks become remote
+// point-to-point channels, and the simulator takes its lookahead from their
+// smallest delay. Applications go on local nodes only (IsLocalNode), and
+// after the run every collector reduces its counters to rank 0, which writes
+// the results. Without an MPI-enabled ns-3 build (NS3_MPI) everything here
+// degrades to a single rank.
+//
+// Typical use, e.g. one rank per router domain of the default network:
+//   mpirun -np 4 ./packet_drop --Distributed=true
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "running_stats.h"
+#include "topology_builder.h"
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#include <mpi.h>
+#endif
+
+using namespace ns3;
+
+// Switches to the distributed simulator; call before anything is scheduled
+inline void EnableDistributed(int& argc, char**& argv) {
+#ifdef NS3_MPI
+    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::DistributedSimulatorImpl"));
+    MpiInterface::Enable(&argc, &argv);
+#else
+    (void)argc;
+    (void)argv;
+    std::cerr << "Warning: ns-3 was built without MPI, running as a single process" << std::endl;
+#endif
+}
+
+// Call after Simulator::Destroy()
+inline void DisableDistributed() {
+#ifdef NS3_MPI
+    if (MpiInterface::IsEnabled()) {
+        MpiInterface::Disable();
+    }
+#endif
+}
+
+inline uint32_t MpiRank() {
+#ifdef NS3_MPI
+    return MpiInterface::IsEnabled() ? MpiInterface::GetSystemId() : 0;
+#else
+    return 0;
+#endif
+}
+
+inline uint32_t MpiSize() {
+#ifdef NS3_MPI
+    return MpiInterface::IsEnabled() ? MpiInterface::GetSize() : 1;
+#else
+    return 1;
+#endif
+}
+
+inline bool IsLocalNode(Ptr<Node> node) {
+    return node->GetSystemId() == MpiRank();
+}
+
+// System id per node index (hosts first, then routers) for 'parts' ranks.
+// Routers are ordered breadth-first over the router-router links and cut
+// into 'parts' contiguous runs, so each rank gets a connected router domain
+// where the graph allows; every host goes with the router of its first link.
+inline std::vector<uint32_t> PartitionByRouterDomain(const std::vector<std::string>& hostNames,
+                                                     const std::vector<std::string>& routerNames,
+                                                     const std::vector<LinkSpec>& links, uint32_t parts) {
+    uint32_t nHosts = hostNames.size();
+    uint32_t nRouters = routerNames.size();
+    std::vector<uint32_t> systemIds(nHosts + nRouters, 0);
+    if (parts <= 1 || nRouters == 0) {
+        return systemIds;
+    }
+    std::unordered_map<std::string, uint32_t> index;
+    for (uint32_t i = 0; i < nHosts + nRouters; ++i) {
+        index[i < nHosts ? hostNames[i] : routerNames[i - nHosts]] = i;
+    }
+    std::vector<std::vector<uint32_t>> adjacent(nRouters);
+    std::vector<uint32_t> hostRouter(nHosts, nHosts);
+    for (const LinkSpec& link : links) {
+        uint32_t a = index.at(link.a);
+        uint32_t b = index.at(link.b);
+        if (a >= nHosts && b >= nHosts) {
+            adjacent[a - nHosts].push_back(b - nHosts);
+            adjacent[b - nHosts].push_back(a - nHosts);
+        } else if (a < nHosts && b >= nHosts && hostRouter[a] == nHosts) {
+            hostRouter[a] = b;
+        } else if (b < nHosts && a >= nHosts && hostRouter[b] == nHosts) {
+            hostRouter[b] = a;
+        }
+    }
+
+    std::vector<uint32_t> order;
+    std::vector<bool> seen(nRouters, false);
+    for (uint32_t root = 0; root < nRouters; ++root) {
+        if (seen[root]) {
+            continue;
+        }
+        std::deque<uint32_t> frontier{root};
+        seen[root] = true;
+        while (!frontier.empty()) {
+            uint32_t r = frontier.front();
+            frontier.pop_front();
+            order.push_back(r);
+            for (uint32_t next : adjacent[r]) {
+                if (!seen[next]) {
+                    seen[next] = true;
+                    frontier.push_back(next);
+                }
+            }
+        }
+    }
+    parts = std::min(parts, nRouters);
+    for (uint32_t k = 0; k < nRouters; ++k) {
+        systemIds[nHosts + order[k]] = uint64_t(k) * parts / nRouters;
+    }
+    for (uint32_t h = 0; h < nHosts; ++h) {
+        systemIds[h] = hostRouter[h] < systemIds.size() ? systemIds[hostRouter[h]] : 0;
+    }
+    return systemIds;
+}
+
+enum class RankReduce { kSum, kMax };
+
+#ifdef NS3_MPI
+inline MPI_Datatype MpiType(const uint32_t*) { return MPI_UINT32_T; }
+inline MPI_Datatype MpiType(const uint64_t*) { return MPI_UINT64_T; }
+inline MPI_Datatype MpiType(const int64_t*) { return MPI_INT64_T; }
+inline MPI_Datatype MpiType(const double*) { return MPI_DOUBLE; }
+#endif
+
+// Element-wise sum or max of 'data' over all ranks, left on rank 0. A no-op
+// in a single process; every rank must call it, in the same order.
+template <typename T>
+void ReduceToRoot(T* data, size_t n, RankReduce op = RankReduce::kSum) {
+#ifdef NS3_MPI
+    if (MpiSize() <= 1) {
+        return;
+    }
+    const size_t chunk = size_t(1) << 28;   // MPI counts are ints
+    for (size_t offset = 0; offset < n; offset += chunk) {
+        int count = int(std::min(chunk, n - offset));
+        void* send = MpiRank() == 0 ? MPI_IN_PLACE : data + offset;
+        MPI_Reduce(send, data + offset, count, MpiType(data), op == RankReduce::kSum ? MPI_SUM : MPI_MAX, 0,
+                   MPI_COMM_WORLD);
+    }
+#else
+    (void)data;
+    (void)n;
+    (void)op;
+#endif
+}
+
+#ifdef NS3_MPI
+// MPI reduction op merging packed RunningStats (count, mean, m2, min, max)
+inline void MergePackedStats(void* in, void* inout, int* len, MPI_Datatype*) {
+    const double* a = static_cast<const double*>(in);
+    double* b = static_cast<double*>(inout);
+    for (int i = 0; i < *len; ++i, a += 5, b += 5) {
+        RunningStats x{uint64_t(a[0]), a[1], a[2], a[3], a[4]};
+        RunningStats y{uint64_t(b[0]), b[1], b[2], b[3], b[4]};
+        y.Merge(x);
+        b[0] = double(y.count);
+        b[1] = y.mean;
+        b[2] = y.m2;
+        b[3] = y.min;
+        b[4] = y.max;
+    }
+}
+#endif
+
+// Merges every rank's statistics into rank 0's with RunningStats::Merge
+inline void MergeStatsToRoot(std::vector<RunningStats>& stats) {
+#ifdef NS3_MPI
+    if (MpiSize() <= 1) {
+        return;
+    }
+    std::vector<double> packed(stats.size() * 5);
+    for (size_t i = 0; i < stats.size(); ++i) {
+        packed[i * 5] = double(stats[i].count);
+        packed[i * 5 + 1] = stats[i].mean;
+        packed[i * 5 + 2] = stats[i].m2;
+        packed[i * 5 + 3] = stats[i].min;
+        packed[i * 5 + 4] = stats[i].max;
+    }
+    MPI_Datatype packedType;
+    MPI_Type_contiguous(5, MPI_DOUBLE, &packedType);
+    MPI_Type_commit(&packedType);
+    MPI_Op merge;
+    MPI_Op_create(&MergePackedStats, 1, &merge);
+    void* send = MpiRank() == 0 ? MPI_IN_PLACE : packed.data();
+    MPI_Reduce(send, packed.data(), int(stats.size()), packedType, merge, 0, MPI_COMM_WORLD);
+    MPI_Op_free(&merge);
+    MPI_Type_free(&packedType);
+    if (MpiRank() == 0) {
+        for (size_t i = 0; i < stats.size(); ++i) {
+            stats[i] = {uint64_t(packed[i * 5]), packed[i * 5 + 1], packed[i * 5 + 2], packed[i * 5 + 3],
+                        packed[i * 5 + 4]};
+        }
+    }
+#else
+    (void)stats;
+#endif
+}
+
+#endif // DISTRIBUTED_H
@@ -0,0 +1,188 @@
+#ifndef DROP_ACCOUNTING_H
+#define DROP_ACCOUNTING_H
+
+// Counts every packet loss by where and why it happened:
+//   error_model    - the receiving device's PhyRxDrop (receive error model)
+//   queue_overflow - a transmit queue's Drop: the device's root queue disc
+//                    (where the point-to-point device's flow control makes
+//                    overflow happen) or the device queue itself
+//   no_route, ttl_expired, other_ip - Ipv4L3Protocol's Drop, by reason
+// Losses on a link are charged to the direction the packet was travelling in
+// (numbered link * 2 + side like NodeAliasTable interfaces, side being the
+// sending end). IP drops of packets that were not received from a link, e.g.
+// locally generated ones with no route, get one extra row per node.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+#include "distributed.h"
+#include "run_profiler.h"
+#include "topology_builder.h"
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+class DropAccounting {
+public:
+    enum Cause { kErrorModel, kQueueOverflow, kNoRoute, kTtlExpired, kOtherIp, kCauses };
+
+    static const char* CauseName(uint32_t cause) {
+        static const char* names[kCauses] = {"error_model", "queue_overflow", "no_route", "ttl_expired", "other_ip"};
+        return names[cause];
+    }
+
+    explicit DropAccounting(const Topology& topo)
+        : m_nDirections(topo.links.size() * 2),
+          m_counts((m_nDirections + topo.nodes.GetN()) * kCauses, 0),
+          m_interfaceDirection(topo.nodes.GetN()) {
+        for (uint32_t link = 0; link < topo.links.size(); ++link) {
+            uint32_t ends[2] = {topo.Index(topo.links[link].a), topo.Index(topo.links[link].b)};
+            for (uint32_t side = 0; side < 2; ++side) {
+                // Rows: what this end sends, then what it receives
+                m_rowFrom.push_back(topo.names[ends[side]]);
+                m_rowTo.push_back(topo.names[ends[1 - side]]);
+                uint32_t sent = link * 2 + side;
+                uint32_t received = link * 2 + (1 - side);
+
+                Ptr<NetDevice> device = topo.linkDevices[link].Get(side);
+                device->TraceConnectWithoutContext(
+                    "PhyRxDrop", MakeBoundCallback(&DropAccounting::DeviceDrop, this, received * kCauses + kErrorModel));
+                Ptr<PointToPointNetDevice> p2p = DynamicCast<PointToPointNetDevice>(device);
+                if (p2p) {
+                    p2p->GetQueue()->TraceConnectWithoutContext(
+                        "Drop", MakeBoundCallback(&DropAccounting::DeviceDrop, this, sent * kCauses + kQueueOverflow));
+                }
+                Ptr<TrafficControlLayer> tc = device->GetNode()->GetObject<TrafficControlLayer>();
+                Ptr<QueueDisc> disc = tc ? tc->GetRootQueueDiscOnDevice(device) : nullptr;
+                if (disc) {
+                    disc->TraceConnectWithoutContext(
+                        "Drop", MakeBoundCallback(&DropAccounting::DiscDrop, this, sent * kCauses + kQueueOverflow));
+                }
+
+                int32_t interface = topo.nodes.Get(ends[side])->GetObject<Ipv4>()->GetInterfaceForDevice(device);
+                std::vector<int64_t>& directions = m_interfaceDirection[ends[side]];
+                if (interface >= 0) {
+                    if (directions.size() <= uint32_t(interface)) {
+                        directions.resize(interface + 1, -1);
+                    }
+                    directions[interface] = received;
+                }
+            }
+        }
+        for (uint32_t i = 0; i < topo.nodes.GetN(); ++i) {
+            m_rowFrom.push_back(topo.names[i]);
+            m_rowTo.push_back("local");
+            Ptr<Ipv4L3Protocol> ipv4 = topo.nodes.Get(i)->GetObject<Ipv4L3Protocol>();
+            if (ipv4) {
+                ipv4->TraceConnectWithoutContext("Drop", MakeBoundCallback(&DropAccounting::IpDrop, this, i));
+            }
+        }
+    }
+
+    uint64_t Get(uint32_t row, uint32_t cause) const { return m_counts[row * kCauses + cause]; }
+
+    uint64_t Total(uint32_t cause) const {
+        uint64_t total = 0;
+        for (uint32_t row = 0; row < m_rowFrom.size(); ++row) {
+            total += Get(row, cause);
+        }
+        return total;
+    }
+
+    // Sums the counts of all ranks of a distributed run into rank 0's; a
+    // no-op in a single process
+    void MergeRanks() { ReduceToRoot(m_counts.data(), m_counts.size()); }
+
+    // The raw counts, and adding such a dump from another process's run of
+    // the same topology (see forked_partitions.h)
+    void Save(std::ostream& os) const {
+        os.write(reinterpret_cast<const char*>(m_counts.data()), m_counts.size() * sizeof(uint64_t));
+    }
+
+    bool MergeFrom(std::istream& is) {
+        std::vector<uint64_t> counts(m_counts.size());
+        if (!is.read(reinterpret_cast<char*>(counts.data()), counts.size() * sizeof(uint64_t))) {
+            return false;
+        }
+        for (size_t i = 0; i < counts.size(); ++i) {
+            m_counts[i] += counts[i];
+        }
+        return true;
+    }
+
+    // Table of the rows with any drops, and a "from,to,<cause>..." CSV of all rows
+    bool Write(const std::string& textPath, const std::string& csvPath) const {
+        std::ofstream text(textPath);
+        std::ofstream csv(csvPath);
+        if (!text.is_open() || !csv.is_open()) {
+            return false;
+        }
+        text << "Packet Drops by Link and Cause:\n" << std::setw(16) << "Link";
+        csv << "from,to";
+        for (uint32_t c = 0; c < kCauses; ++c) {
+            text << std::setw(16) << CauseName(c);
+            csv << "," << CauseName(c);
+        }
+        text << "\n";
+        csv << "\n";
+        for (uint32_t row = 0; row < m_rowFrom.size(); ++row) {
+            uint64_t any = 0;
+            csv << m_rowFrom[row] << "," << m_rowTo[row];
+            for (uint32_t c = 0; c < kCauses; ++c) {
+                csv << "," << Get(row, c);
+                any += Get(row, c);
+            }
+            csv << "\n";
+            if (any) {
+                text << std::setw(16) << (m_rowFrom[row] + " -> " + m_rowTo[row]);
+                for (uint32_t c = 0; c < kCauses; ++c) {
+                    text << std::setw(16) << Get(row, c);
+                }
+                text << "\n";
+            }
+        }
+        text << std::setw(16) << "Total";
+        for (uint32_t c = 0; c < kCauses; ++c) {
+            text << std::setw(16) << Total(c);
+        }
+        text << "\n";
+        return text.good() && csv.good();
+    }
+
+private:
+    static void DeviceDrop(DropAccounting* accounting, uint32_t cell, Ptr<const Packet>) {
+        ++TraceCallbackCount();
+        ++accounting->m_counts[cell];
+    }
+
+    static void DiscDrop(DropAccounting* accounting, uint32_t cell, Ptr<const QueueDiscItem>) {
+        ++TraceCallbackCount();
+        ++accounting->m_counts[cell];
+    }
+
+    static void IpDrop(DropAccounting* accounting, uint32_t node, const Ipv4Header&, Ptr<const Packet>,
+                       Ipv4L3Protocol::DropReason reason, Ptr<Ipv4>, uint32_t interface) {
+        ++TraceCallbackCount();
+        uint32_t cause = reason == Ipv4L3Protocol::DROP_NO_ROUTE      ? kNoRoute
+                         : reason == Ipv4L3Protocol::DROP_TTL_EXPIRED ? kTtlExpired
+                                                                      : kOtherIp;
+        const std::vector<int64_t>& directions = accounting->m_interfaceDirection[node];
+        uint32_t row = interface < directions.size() && directions[interface] >= 0
+                           ? directions[interface]
+                           : accounting->m_nDirections + node;
+        ++accounting->m_counts[row * kCauses + cause];
+    }
+
+    uint32_t m_nDirections;
+    std::vector<uint64_t> m_counts;   // row-major, kCauses per row
+    std::vector<std::string> m_rowFrom;
+    std::vector<std::string> m_rowTo;
+    std::vector<std::vector<int64_t>> m_interfaceDirection;   // [node][interface] -> direction received on
+};
+
+#endif // DROP_ACCOUNTING_H
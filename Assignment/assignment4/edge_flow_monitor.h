@@ -0,0 +1,209 @@
+#ifndef EDGE_FLOW_MONITOR_H
+#define EDGE_FLOW_MONITOR_H
+
+// End-to-end flow statistics measured at the hosts only, a cheaper stand-in
+// for FlowMonitorHelper::InstallAll() when nothing per hop is needed. It hooks
+// SendOutgoing and LocalDeliver on the hosts' IPv4 stacks, so routers run no
+// probe code at all. The sender stamps each packet with a small packet tag
+// carrying its send time, and the receiver reads the delay back from it, so
+// nothing is kept per packet in flight: a flow (5-tuple) is just tx/rx
+// counters, byte counts and RunningStats of its delays. With 'sampleEvery' N
+// > 0, every Nth packet a flow sends is also marked for its delay histogram.
+// Loss is tx - rx, so packets still in flight when the run stops count as
+// lost; stop the traffic a little before the simulation.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "run_profiler.h"
+#include "running_stats.h"
+#include "topology_builder.h"
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+// Send time of a packet, and whether it belongs to the delay histogram sample
+class EdgeFlowTag : public Tag {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("EdgeFlowTag").SetParent<Tag>().AddConstructor<EdgeFlowTag>();
+        return tid;
+    }
+    TypeId GetInstanceTypeId() const override { return GetTypeId(); }
+    uint32_t GetSerializedSize() const override { return 9; }
+    void Serialize(TagBuffer buffer) const override {
+        buffer.WriteU64(uint64_t(sendNs));
+        buffer.WriteU8(sampled);
+    }
+    void Deserialize(TagBuffer buffer) override {
+        sendNs = int64_t(buffer.ReadU64());
+        sampled = buffer.ReadU8();
+    }
+    void Print(std::ostream& os) const override { os << "sent=" << sendNs << "ns sampled=" << int(sampled); }
+
+    int64_t sendNs = 0;
+    uint8_t sampled = 0;
+};
+
+class EdgeFlowMonitor {
+public:
+    struct Flow {
+        Ipv4Address source;
+        Ipv4Address destination;
+        uint8_t protocol = 0;
+        uint16_t sourcePort = 0;
+        uint16_t destinationPort = 0;
+        uint64_t txPackets = 0;
+        uint64_t rxPackets = 0;
+        uint64_t txBytes = 0;
+        uint64_t rxBytes = 0;
+        RunningStats delay;         // seconds, every received packet
+        Histogram sampledDelay;     // seconds, the sampled packets that arrived
+    };
+
+    EdgeFlowMonitor(const Topology& topo, uint32_t sampleEvery = 0, double histogramBinSeconds = 0.001,
+                    uint32_t histogramBins = 200)
+        : m_sampleEvery(sampleEvery),
+          m_histogram(sampleEvery ? Histogram(histogramBinSeconds, histogramBins) : Histogram()) {
+        for (uint32_t i = 0; i < topo.hosts.GetN(); ++i) {
+            Ptr<Ipv4L3Protocol> ipv4 = topo.hosts.Get(i)->GetObject<Ipv4L3Protocol>();
+            if (ipv4) {
+                ipv4->TraceConnectWithoutContext("SendOutgoing", MakeBoundCallback(&EdgeFlowMonitor::Send, this));
+                ipv4->TraceConnectWithoutContext("LocalDeliver", MakeBoundCallback(&EdgeFlowMonitor::Deliver, this));
+            }
+        }
+    }
+
+    // In first-seen order. In a distributed run each rank only has the sends
+    // and receives of its own hosts.
+    const std::vector<Flow>& GetFlows() const { return m_flows; }
+
+    bool WriteCsv(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << std::setprecision(9)
+             << "src,dst,protocol,src_port,dst_port,tx_packets,rx_packets,lost_packets,tx_bytes,rx_bytes,"
+                "mean_delay,delay_variance,min_delay,max_delay\n";
+        for (const Flow& f : m_flows) {
+            file << f.source << "," << f.destination << "," << int(f.protocol) << "," << f.sourcePort << ","
+                 << f.destinationPort << "," << f.txPackets << "," << f.rxPackets << ","
+                 << (f.txPackets > f.rxPackets ? f.txPackets - f.rxPackets : 0) << "," << f.txBytes << ","
+                 << f.rxBytes << "," << f.delay.mean << "," << f.delay.Variance() << ","
+                 << (f.delay.count ? f.delay.min : 0.0) << "," << (f.delay.count ? f.delay.max : 0.0) << "\n";
+        }
+        return file.good();
+    }
+
+    // "src,dst,src_port,dst_port,bin_start,count" for every non-empty bucket
+    bool WriteHistogramCsv(const std::string& path) const {
+        if (!m_sampleEvery) {
+            return true;
+        }
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << std::setprecision(9) << "src,dst,src_port,dst_port,bin_start,count\n";
+        for (const Flow& f : m_flows) {
+            for (size_t b = 0; b < f.sampledDelay.counts.size(); ++b) {
+                if (f.sampledDelay.counts[b]) {
+                    file << f.source << "," << f.destination << "," << f.sourcePort << "," << f.destinationPort
+                         << "," << b * f.sampledDelay.binWidth << "," << f.sampledDelay.counts[b] << "\n";
+                }
+            }
+        }
+        return file.good();
+    }
+
+private:
+    struct FlowKey {
+        uint32_t source;
+        uint32_t destination;
+        uint16_t sourcePort;
+        uint16_t destinationPort;
+        uint8_t protocol;
+        bool operator==(const FlowKey& o) const {
+            return source == o.source && destination == o.destination && sourcePort == o.sourcePort &&
+                   destinationPort == o.destinationPort && protocol == o.protocol;
+        }
+    };
+
+    struct FlowKeyHash {
+        size_t operator()(const FlowKey& k) const {
+            uint64_t h = (uint64_t(k.source) << 32 | k.destination) * 0x9e3779b97f4a7c15ULL;
+            h ^= (uint64_t(k.sourcePort) << 24 | uint64_t(k.destinationPort) << 8 | k.protocol) + (h >> 29);
+            return size_t(h * 0xbf58476d1ce4e5b9ULL);
+        }
+    };
+
+    // The flow of an IP payload, created on first sight. Ports come from the
+    // first four payload bytes, which is where UDP and TCP keep them.
+    Flow& FlowOf(const Ipv4Header& header, Ptr<const Packet> payload) {
+        FlowKey key{header.GetSource().Get(), header.GetDestination().Get(), 0, 0, header.GetProtocol()};
+        if ((key.protocol == 6 || key.protocol == 17) && payload->GetSize() >= 4) {
+            uint8_t ports[4];
+            payload->CopyData(ports, 4);
+            key.sourcePort = uint16_t(ports[0] << 8 | ports[1]);
+            key.destinationPort = uint16_t(ports[2] << 8 | ports[3]);
+        }
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            return m_flows[it->second];
+        }
+        m_index.emplace(key, m_flows.size());
+        m_flows.emplace_back();
+        Flow& flow = m_flows.back();
+        flow.source = header.GetSource();
+        flow.destination = header.GetDestination();
+        flow.protocol = key.protocol;
+        flow.sourcePort = key.sourcePort;
+        flow.destinationPort = key.destinationPort;
+        flow.sampledDelay = m_histogram;
+        return flow;
+    }
+
+    static void Send(EdgeFlowMonitor* monitor, const Ipv4Header& header, Ptr<const Packet> payload, uint32_t) {
+        ++TraceCallbackCount();
+        Flow& flow = monitor->FlowOf(header, payload);
+        EdgeFlowTag tag;
+        tag.sendNs = Simulator::Now().GetNanoSeconds();
+        tag.sampled = monitor->m_sampleEvery && flow.txPackets % monitor->m_sampleEvery == 0;
+        ++flow.txPackets;
+        flow.txBytes += payload->GetSize() + header.GetSerializedSize();
+        // Tags live outside the packet bytes, as FlowMonitor's probe tags do;
+        // a payload sent again keeps one tag, with the new time
+        Packet* packet = const_cast<Packet*>(PeekPointer(payload));
+        if (!packet->ReplacePacketTag(tag)) {
+            packet->AddPacketTag(tag);
+        }
+    }
+
+    static void Deliver(EdgeFlowMonitor* monitor, const Ipv4Header& header, Ptr<const Packet> payload, uint32_t) {
+        ++TraceCallbackCount();
+        EdgeFlowTag tag;
+        if (!payload->PeekPacketTag(tag)) {
+            return;   // not sent from a monitored host
+        }
+        Flow& flow = monitor->FlowOf(header, payload);
+        double delay = (Simulator::Now() - NanoSeconds(tag.sendNs)).GetSeconds();
+        ++flow.rxPackets;
+        flow.rxBytes += payload->GetSize() + header.GetSerializedSize();
+        flow.delay.Add(delay);
+        if (tag.sampled) {
+            flow.sampledDelay.Add(delay);
+        }
+    }
+
+    uint32_t m_sampleEvery;
+    Histogram m_histogram;   // empty copy given to every new flow
+    std::unordered_map<FlowKey, uint32_t, FlowKeyHash> m_index;
+    std::vector<Flow> m_flows;
+};
+
+#endif // EDGE_FLOW_MONITOR_H
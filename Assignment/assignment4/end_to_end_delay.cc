@@ -3,175 +3,168 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/applications-module.h"
-#include "ns3/flow-monitor-module.h"
+#include "topology_builder.h"
+#include "topology_generator.h"
+#include "experiment_options.h"
+#include "run_profiler.h"
+#include "incremental_router.h"
+#include "error_models.h"
+#include "traffic_generator.h"
+#include "link_utilization.h"
+#include "delay_probe.h"
+#include "distributed.h"
+#include "forked_partitions.h"
 #include <iomanip>
 #include <map>
 #include <vector>
 #include <string>
 #include <fstream>
+#include <thread>
 
 using namespace ns3;
 
-// Declare IP to Node name mapping
-std::map<Ipv4Address, std::string> ipToNodeName;
-
 NS_LOG_COMPONENT_DEFINE("EndToEndDelaySimulation");
 
+// Delay matrices as text, plus one CSV row per pair for the sweep runner and
+// the histograms
+static bool WriteDelayResults(const DelayProbe& delayProbe, const std::string& outputDir) {
+    std::ofstream outFile(outputDir + "/delay_calculation.txt");
+    if (!outFile.is_open()) {
+        std::cerr << "Error: Could not open the file for writing results." << std::endl;
+        return false;
+    }
+    delayProbe.WriteText(outFile);
+    outFile.close();
+
+    if (!delayProbe.WriteCsv(outputDir + "/delay_calculation.csv") ||
+        !delayProbe.WriteHistogramCsv(outputDir + "/delay_histogram.csv")) {
+        std::cerr << "Error: Could not write the delay CSV files." << std::endl;
+        return false;
+    }
+    return true;
+}
+
 int main(int argc, char *argv[]) {
+    ExperimentOptions options;
+    options.errorRate = 0.0;
+    double histogramBin = 0.0;
+    uint32_t histogramBins = 100;
+    double utilizationWindow = 1.0;
+    double saturationThreshold = 0.9;
+    bool distributed = false;
+    uint32_t isolate = 0;
+    uint32_t workers = std::thread::hardware_concurrency();
     CommandLine cmd;
-    cmd.Parse(argc, argv);
+    AddExperimentOptions(cmd, options);
+    cmd.AddValue("UtilizationWindow", "Sliding window for link utilization (seconds)", utilizationWindow);
+    cmd.AddValue("SaturationThreshold", "Windowed utilization at which a link counts as saturated", saturationThreshold);
+    cmd.AddValue("HistogramBin", "Delay histogram bucket width in seconds (0 disables the histograms)", histogramBin);
+    cmd.AddValue("HistogramBins", "Number of delay histogram buckets, the last one open-ended", histogramBins);
+    cmd.AddValue("Distributed", "Run as MPI ranks, one router domain each (start with mpirun)", distributed);
+    cmd.AddValue("Isolate", "Run the sources in this many groups (source i in group i % Isolate), each "
+                 "alone in its own process, and merge their delays (0 or 1: all together)", isolate);
+    cmd.AddValue("Workers", "Source groups run at the same time with Isolate", workers);
+    ParseExperimentOptions(cmd, options, argc, argv);
+    if (distributed) {
+        EnableDistributed(argc, argv);
+    }
 
     Time::SetResolution(Time::NS);
-    LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
-    LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
-
-    // Create 7 hosts (A-G) and 4 routers (R1-R4)
-    NodeContainer hosts;
-    hosts.Create(7);
-    NodeContainer routers;
-    routers.Create(4);
-
-    InternetStackHelper stack;
-    stack.Install(hosts);
-    stack.Install(routers);
-
-    PointToPointHelper p2p;
-    NetDeviceContainer hostDevices[7];
-    NetDeviceContainer routerDevices;
-
-    // Host-to-Router connections
-    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps"));
-    hostDevices[0] = p2p.Install(NodeContainer(hosts.Get(0), routers.Get(0))); // A - R1
-    hostDevices[1] = p2p.Install(NodeContainer(hosts.Get(1), routers.Get(0))); // B - R1
-    hostDevices[2] = p2p.Install(NodeContainer(hosts.Get(2), routers.Get(2))); // C - R3
-    hostDevices[3] = p2p.Install(NodeContainer(hosts.Get(3), routers.Get(2))); // D - R3
-    hostDevices[4] = p2p.Install(NodeContainer(hosts.Get(4), routers.Get(1))); // E - R2
-    hostDevices[5] = p2p.Install(NodeContainer(hosts.Get(5), routers.Get(1))); // F - R2
-    hostDevices[6] = p2p.Install(NodeContainer(hosts.Get(6), routers.Get(3))); // G - R4
-
-    // Router-to-Router connections
-    p2p.SetDeviceAttribute("DataRate", StringValue("3Mbps"));
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(0), routers.Get(1)))); // R1 - R2
-    p2p.SetDeviceAttribute("DataRate", StringValue("2.5Mbps"));
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(0), routers.Get(2)))); // R1 - R3
-    p2p.SetDeviceAttribute("DataRate", StringValue("1.5Mbps"));
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(2), routers.Get(3)))); // R3 - R4
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps"));
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(1), routers.Get(3)))); // R2 - R4
-
-    // Assign IP addresses
-    Ipv4AddressHelper address;
-    std::string baseIp = "10.1.";
-    for (uint32_t i = 0; i < 7; ++i) {
-        address.SetBase(Ipv4Address((baseIp + std::to_string(i) + ".0").c_str()), "255.255.255.0");
-        address.Assign(hostDevices[i]);
+    if (options.logPackets) {
+        LogComponentEnable("PacketSink", LOG_LEVEL_INFO);
     }
 
-    for (uint32_t i = 0; i < routerDevices.GetN(); ++i) {
-        address.SetBase(Ipv4Address((baseIp + std::to_string(i + 7) + ".0").c_str()), "255.255.255.0");
-        address.Assign(routerDevices.Get(i));
+    // Same A-G / R1-R4 network, but every host link runs at 1Mbps
+    std::vector<std::string> hostNames = DefaultHostNames();
+    std::vector<std::string> routerNames = DefaultRouterNames();
+    std::vector<LinkSpec> links = DefaultLinkTable();
+    for (uint32_t i = 0; i < hostNames.size(); ++i) {
+        links[i].dataRate = "1Mbps";
     }
-
-    // IP-to-Node Mapping
-    ipToNodeName[Ipv4Address("10.1.0.1")] = "A";
-    ipToNodeName[Ipv4Address("10.1.1.1")] = "B";
-    ipToNodeName[Ipv4Address("10.1.2.1")] = "C";
-    ipToNodeName[Ipv4Address("10.1.3.1")] = "D";
-    ipToNodeName[Ipv4Address("10.1.4.1")] = "E";
-    ipToNodeName[Ipv4Address("10.1.5.1")] = "F";
-    ipToNodeName[Ipv4Address("10.1.6.1")] = "G";
-
-    // Set up UDP Echo server on all hosts
-    UdpEchoServerHelper echoServer(9);
-    ApplicationContainer serverApps;
-    for (uint32_t i = 0; i < 7; ++i) {
-        serverApps.Add(echoServer.Install(hosts.Get(i)));
+    if (!options.linkTable.empty()) {
+        LoadLinkTable(options.linkTable, hostNames, routerNames, links);
+    }
+    if (!options.topology.empty()) {
+        GenerateTopology(options.topology, hostNames, routerNames, links);
     }
-    serverApps.Start(Seconds(1.0));
-    serverApps.Stop(Seconds(10.0));
-
-    // Set up UDP Echo clients
-    for (uint32_t i = 0; i < 7; ++i) {
-        for (uint32_t j = 0; j < 7; ++j) {
-            if (i != j) { // Avoid self-traffic
-                UdpEchoClientHelper echoClient(Ipv4Address(("10.1." + std::to_string(j) + ".1").c_str()), 9);
-                echoClient.SetAttribute("MaxPackets", UintegerValue(1000));
-                echoClient.SetAttribute("Interval", TimeValue(Seconds(0.01)));
-                echoClient.SetAttribute("PacketSize", UintegerValue(1024));
-                ApplicationContainer clientApps = echoClient.Install(hosts.Get(i));
-                clientApps.Start(Seconds(2.0 + i + j));
-                clientApps.Stop(Seconds(10.0));
-            }
-        }
+    InternetStackHelper stack;
+    Topology topo = BuildTopology(hostNames, routerNames, links, stack, ExperimentAddressPlan(options),
+                                  PartitionByRouterDomain(hostNames, routerNames, links, MpiSize()));
+    NodeContainer hosts = topo.hosts;
+
+    // An independent error model per link, from the link table's loss column
+    // (ErrorRate on links without one), each on its own RNG streams
+    InstallErrorModels(topo, options.errorRate);
+
+    // Global routing, or the incremental router when links fail during the run
+    std::unique_ptr<IncrementalRouter> router = SetUpRouting(topo, options.linkEvents);
+
+    // Every host sends to every other host (to the next Peers hosts with
+    // --Peers): Poisson arrivals averaging one packet per Interval per pair,
+    // for as long as MaxPackets packets take on average
+    TrafficMatrix traffic = PeerTrafficMatrix(hostNames, options.peers, 1);
+    Time trafficStop = Seconds(std::min(options.appStopTime, 2.0 + options.maxPackets * options.interval));
+
+    // With Isolate, each group of sources runs alone in a forked copy of this
+    // process, on the network built above; their delay statistics are merged
+    if (isolate > 1) {
+        NS_ABORT_MSG_IF(distributed, "Isolate and Distributed cannot be combined");
+        DelayProbe delayProbe(topo, histogramBin, histogramBins);
+        bool ok = RunForkedPartitions(
+            isolate, workers,
+            [&](uint32_t group, std::ostream& out) {
+                InstallMatrixTraffic(topo, SourceGroup(traffic, group, isolate), 1.0 / options.interval,
+                                     options.packetSize, 9, Seconds(2.0), trafficStop, 0);
+                DelayProbe groupProbe(topo, histogramBin, histogramBins);
+                Simulator::Stop(Seconds(options.stopTime));
+                Simulator::Run();
+                groupProbe.Save(out);
+                Simulator::Destroy();
+            },
+            [&](uint32_t group, std::istream& in) {
+                if (!delayProbe.MergeFrom(in)) {
+                    std::cerr << "Error: truncated results from source group " << group << std::endl;
+                }
+            });
+        bool written = WriteDelayResults(delayProbe, options.outputDir);
+        Simulator::Destroy();
+        return ok && written ? 0 : 1;
     }
 
-    // Enable routing
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    InstallMatrixTraffic(topo, traffic, 1.0 / options.interval, options.packetSize, 9, Seconds(2.0), trafficStop, 0);
+
+    // Per-direction link utilization, counted as packets leave each device
+    LinkUtilizationMonitor utilization(topo, Seconds(utilizationWindow), saturationThreshold);
 
-    // Flow Monitor setup
-    Ptr<FlowMonitor> flowMonitor;
-    FlowMonitorHelper flowHelper;
-    flowMonitor = flowHelper.InstallAll();
+    // Per-pair delay statistics, updated as packets arrive
+    DelayProbe delayProbe(topo, histogramBin, histogramBins);
 
     // Run simulation
-    Simulator::Stop(Seconds(60.0));
+    Simulator::Stop(Seconds(options.stopTime));
+    RunProfiler profiler(topo, options.profile);
     Simulator::Run();
-
-    // Analyze Flow Monitor results
-    std::vector<std::vector<double>> avgDelays(7, std::vector<double>(7, 0.0));
-    std::vector<std::vector<double>> varDelays(7, std::vector<double>(7, 0.0));
-
-    Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flowHelper.GetClassifier());
-    for (const auto& flowStat : flowMonitor->GetFlowStats()) {
-        Ipv4FlowClassifier::FiveTuple tuple = classifier->FindFlow(flowStat.first);
-        auto srcIter = ipToNodeName.find(tuple.sourceAddress);
-        auto dstIter = ipToNodeName.find(tuple.destinationAddress);
-
-        if (srcIter == ipToNodeName.end() || dstIter == ipToNodeName.end()) {
-            continue;
-        }
-
-        uint32_t srcIndex = srcIter->second[0] - 'A';
-        uint32_t dstIndex = dstIter->second[0] - 'A';
-
-        double avgDelay = flowStat.second.delaySum.GetSeconds() / flowStat.second.rxPackets;
-        double delayVar = ((flowStat.second.jitterSum.GetSeconds() / flowStat.second.rxPackets) * 2); // Approximation
-
-        avgDelays[srcIndex][dstIndex] = avgDelay;
-        varDelays[srcIndex][dstIndex] = delayVar;
+    profiler.Finish(std::cout);
+    utilization.Finish(Simulator::Now());
+
+    // In a distributed run rank 0 collects everything and writes the results
+    utilization.MergeRanks();
+    delayProbe.MergeRanks();
+    if (MpiRank() != 0) {
+        Simulator::Destroy();
+        DisableDistributed();
+        return 0;
     }
-
-    // Print results
-    std::ofstream outFile("delay_calculation.txt");
-    if (!outFile.is_open()) {
-    std::cerr << "Error: Could not open the file for writing results." << std::endl;
-    Simulator::Destroy();
-    return 1;
-}
-    outFile << std::fixed << std::setprecision(6);
-    outFile << "Average End-to-End Delays (seconds):" << std::endl;
-    outFile << "To:       A          B          C          D          E          F          G" << std::endl;
-    for (uint32_t i = 0; i < 7; ++i) {
-        outFile << char('A' + i) << "   ";
-        for (uint32_t j = 0; j < 7; ++j) {
-            outFile << avgDelays[i][j] << "    ";
-        }
-        outFile << std::endl;
+    if (router && !router->WriteLinkChanges(options.outputDir + "/link_changes.txt")) {
+        std::cerr << "Error writing link_changes.txt!" << std::endl;
     }
-
-    outFile << "\nVariance of Delays (seconds):" << std::endl;
-    outFile << "To:       A          B          C          D          E          F          G" << std::endl;
-    for (uint32_t i = 0; i < 7; ++i) {
-        outFile << char('A' + i) << "   ";
-        for (uint32_t j = 0; j < 7; ++j) {
-            outFile << varDelays[i][j] << "    ";
-        }
-        outFile << std::endl;
+    if (!utilization.WriteReport(options.outputDir + "/link_utilization.txt",
+                                 options.outputDir + "/link_utilization.csv")) {
+        std::cerr << "Error writing the link utilization report!" << std::endl;
     }
-    outFile.close();
+    bool written = WriteDelayResults(delayProbe, options.outputDir);
 
     // Clean up
     Simulator::Destroy();
-    return 0;
+    DisableDistributed();
+    return written ? 0 : 1;
 }
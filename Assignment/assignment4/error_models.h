@@ -0,0 +1,166 @@
+#ifndef ERROR_MODELS_H
+#define ERROR_MODELS_H
+
+// Per-link receive error models built from the link table's optional loss
+// column. Every link gets its own model instance on its own RNG streams, so
+// losses on different links are independent and reproducible per run.
+// Loss specs:
+//   <p> or rate:<p>                   independent per-packet loss with probability p
+//   burst:<p>[:<min>-<max>]           BurstErrorModel: a burst starts with probability
+//                                     p and drops min..max packets (default 1-4)
+//   ge:<pGB>:<pBG>[:<lossBad>[:<lossGood>]]
+//                                     Gilbert-Elliott: per-packet Good->Bad and Bad->Good
+//                                     transitions, loss probability per state
+//                                     (defaults 1 and 0)
+//   none                              no losses on this link
+// Links with an empty spec use the experiment's ErrorRate (none if it is 0).
+// As before, the model is installed on the link's 'b' side device.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "topology_builder.h"
+#include "traffic_generator.h"
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+class GilbertElliottErrorModel : public ErrorModel {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("GilbertElliottErrorModel")
+                                .SetParent<ErrorModel>()
+                                .AddConstructor<GilbertElliottErrorModel>();
+        return tid;
+    }
+
+    void SetParameters(double goodToBad, double badToGood, double lossBad, double lossGood) {
+        m_goodToBad = goodToBad;
+        m_badToGood = badToGood;
+        m_lossBad = lossBad;
+        m_lossGood = lossGood;
+    }
+
+    int64_t AssignStreams(int64_t stream) {
+        m_random->SetStream(stream);
+        return 1;
+    }
+
+private:
+    bool DoCorrupt(Ptr<Packet>) override {
+        double transition = m_bad ? m_badToGood : m_goodToBad;
+        if (m_random->GetValue() < transition) {
+            m_bad = !m_bad;
+        }
+        return m_random->GetValue() < (m_bad ? m_lossBad : m_lossGood);
+    }
+
+    void DoReset() override { m_bad = false; }
+
+    double m_goodToBad = 0;
+    double m_badToGood = 1;
+    double m_lossBad = 1;
+    double m_lossGood = 0;
+    bool m_bad = false;
+    Ptr<UniformRandomVariable> m_random = CreateObject<UniformRandomVariable>();
+};
+
+// Reads all of 'text' as a finite number into 'value'; false if any of it
+// is not
+inline bool ParseLossNumber(const std::string& text, double& value) {
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return !text.empty() && end == text.c_str() + text.size() && std::isfinite(value);
+}
+
+// 'text' from 'spec' as a number, aborting with the spec when it is not one
+inline double LossNumber(const std::string& text, const std::string& spec) {
+    double value;
+    NS_ABORT_MSG_IF(!ParseLossNumber(text, value), "Loss spec '" << spec << "' has a bad number '" << text << "'");
+    return value;
+}
+
+// Builds the model for one loss spec and assigns its streams from 'stream'
+// on; 'stream' is advanced past them. Returns null for "no losses".
+inline Ptr<ErrorModel> CreateErrorModel(const std::string& spec, double defaultRate, int64_t& stream) {
+    std::string kind = spec.substr(0, spec.find(':'));
+    std::vector<std::string> fields;
+    if (spec.find(':') != std::string::npos) {
+        std::istringstream rest(spec.substr(spec.find(':') + 1));
+        std::string field;
+        while (std::getline(rest, field, ':')) {
+            fields.push_back(field);
+        }
+    }
+
+    double rate = defaultRate;
+    if (spec.empty() || kind == "rate" || ParseLossNumber(spec, rate)) {
+        if (kind == "rate") {
+            NS_ABORT_MSG_IF(fields.size() != 1, "Loss spec '" << spec << "' needs rate:<p>");
+            rate = LossNumber(fields[0], spec);
+        }
+        if (rate <= 0) {
+            return nullptr;
+        }
+        Ptr<RateErrorModel> model = CreateObject<RateErrorModel>();
+        model->SetAttribute("ErrorRate", DoubleValue(rate));
+        model->SetAttribute("ErrorUnit", StringValue("ERROR_UNIT_PACKET"));
+        stream += model->AssignStreams(stream);
+        return model;
+    }
+    if (kind == "burst") {
+        NS_ABORT_MSG_IF(fields.empty() || fields.size() > 2,
+                        "Loss spec '" << spec << "' needs burst:<p>[:<min>-<max>]");
+        double minSize = 1;
+        double maxSize = 4;
+        if (fields.size() == 2) {
+            size_t dash = fields[1].find('-');
+            NS_ABORT_MSG_IF(dash == std::string::npos, "Loss spec '" << spec << "' needs burst sizes as <min>-<max>");
+            minSize = LossNumber(fields[1].substr(0, dash), spec);
+            maxSize = LossNumber(fields[1].substr(dash + 1), spec);
+            NS_ABORT_MSG_IF(minSize < 1 || maxSize < minSize, "Loss spec '" << spec << "' has bad burst sizes");
+        }
+        Ptr<BurstErrorModel> model = CreateObject<BurstErrorModel>();
+        model->SetAttribute("BurstRate", DoubleValue(LossNumber(fields[0], spec)));
+        std::ostringstream sizes;
+        sizes << "ns3::UniformRandomVariable[Min=" << minSize << "|Max=" << maxSize << "]";
+        model->SetAttribute("BurstSize", StringValue(sizes.str()));
+        stream += model->AssignStreams(stream);
+        return model;
+    }
+    if (kind == "ge") {
+        NS_ABORT_MSG_IF(fields.size() < 2 || fields.size() > 4, "Loss spec '" << spec << "' needs ge:<pGB>:<pBG>");
+        std::vector<double> values;
+        for (const std::string& field : fields) {
+            values.push_back(LossNumber(field, spec));
+        }
+        Ptr<GilbertElliottErrorModel> model = CreateObject<GilbertElliottErrorModel>();
+        model->SetParameters(values[0], values[1], values.size() > 2 ? values[2] : 1.0,
+                             values.size() > 3 ? values[3] : 0.0);
+        stream += model->AssignStreams(stream);
+        return model;
+    }
+    NS_ABORT_MSG_IF(kind != "none", "Unknown loss spec '" << spec << "'");
+    return nullptr;
+}
+
+// Installs one model per link on its 'b' side device. Streams start at
+// 'stream', or by default past the ones the traffic generator gives the
+// hosts' senders (kStreams per host from a base below 1000), so the two
+// ranges stay apart however many hosts there are.
+inline void InstallErrorModels(const Topology& topo, double defaultRate, int64_t stream = -1) {
+    if (stream < 0) {
+        stream = 1000 + int64_t(topo.GetNHosts()) * MatrixTrafficApp::kStreams;
+    }
+    for (uint32_t i = 0; i < topo.links.size(); ++i) {
+        Ptr<ErrorModel> model = CreateErrorModel(topo.links[i].loss, defaultRate, stream);
+        if (model) {
+            topo.linkDevices[i].Get(1)->SetAttribute("ReceiveErrorModel", PointerValue(model));
+        }
+    }
+}
+
+#endif // ERROR_MODELS_H
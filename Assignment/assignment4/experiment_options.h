@@ -0,0 +1,106 @@
+#ifndef EXPERIMENT_OPTIONS_H
+#define EXPERIMENT_OPTIONS_H
+
+// The knobs every assignment4 experiment used to compile in. Each main() sets
+// its own defaults, registers them with AddExperimentOptions() and parses with
+// ParseExperimentOptions(), which also reads --Config files: one "Name=value"
+// (or "Name value") per line, '#' starts a comment. Values from the file are
+// applied first, so anything given on the command line still wins.
+
+#include "ns3/core-module.h"
+#include "address_planner.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+struct ExperimentOptions {
+    double errorRate = 0.01;
+    double interval = 0.01;      // seconds between echo packets
+    uint32_t packetSize = 1024;  // bytes
+    uint32_t maxPackets = 1000;
+    uint32_t peers = 0;          // traffic matrix destinations per host, 0: every other host
+    double appStopTime = 10.0;   // seconds
+    double stopTime = 60.0;      // seconds
+    std::string linkTable;       // empty: the experiment's built-in table
+    std::string topology;        // generator spec (topology_generator.h), replaces the table
+    std::string addressPool = "10.0.0.0/8";
+    uint32_t linkPrefix = 30;    // 30, or 31 for RFC 3021 point-to-point subnets
+    std::string linkEvents;      // empty: links stay up, global routing
+    std::string outputDir = ".";
+    bool logPackets = true;      // NS_LOG every application send/receive
+    bool profile = false;        // print the run profile (run_profiler.h)
+    std::string config;
+};
+
+inline void AddExperimentOptions(CommandLine& cmd, ExperimentOptions& options) {
+    cmd.AddValue("ErrorRate", "Receive error rate on every link (0 disables the error model)", options.errorRate);
+    cmd.AddValue("Interval", "Echo client inter-packet interval (seconds)", options.interval);
+    cmd.AddValue("PacketSize", "Echo client payload size (bytes)", options.packetSize);
+    cmd.AddValue("MaxPackets", "Packets each echo client sends", options.maxPackets);
+    cmd.AddValue("Peers", "Hosts each matrix traffic source sends to, the ones after it in host order "
+                 "(0: every other host)", options.peers);
+    cmd.AddValue("AppStopTime", "Time the echo applications stop (seconds)", options.appStopTime);
+    cmd.AddValue("StopTime", "Time the simulation stops (seconds)", options.stopTime);
+    cmd.AddValue("LinkTable", "Link table file replacing the built-in topology", options.linkTable);
+    cmd.AddValue("Topology", "Generated topology replacing the built-in one, e.g. fattree:k=8 or "
+                 "waxman:routers=1000,hosts=2 (see topology_generator.h)", options.topology);
+    cmd.AddValue("AddressPool", "Prefix the link subnets are allocated from", options.addressPool);
+    cmd.AddValue("LinkPrefix", "Prefix length of each link subnet (30 or 31)", options.linkPrefix);
+    cmd.AddValue("LinkEvents", "Link failures/repairs as <a>-<b>@<seconds>[:up|:down],...; routes follow them",
+                 options.linkEvents);
+    cmd.AddValue("OutputDir", "Directory the result files are written to", options.outputDir);
+    cmd.AddValue("LogPackets", "Log every packet the applications send and receive", options.logPackets);
+    cmd.AddValue("Profile", "Print events/s, wall vs. simulated time, peak memory and a per-packet work "
+                 "breakdown after the run", options.profile);
+    cmd.AddValue("Config", "File of Name=value option lines, applied before the command line", options.config);
+}
+
+// Turns the lines of a --Config file into "--Name=value" arguments.
+inline std::vector<std::string> ReadConfigFile(const std::string& path) {
+    std::ifstream file(path);
+    NS_ABORT_MSG_IF(!file.is_open(), "Cannot open config file " << path);
+    std::vector<std::string> args;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos) {
+            continue;
+        }
+        line = line.substr(start, line.find_last_not_of(" \t\r") - start + 1);
+        size_t sep = line.find_first_of("= \t");
+        NS_ABORT_MSG_IF(sep == std::string::npos, "Config line '" << line << "' has no value");
+        size_t value = line.find_first_not_of("= \t", sep);
+        args.push_back("--" + line.substr(0, sep) + "=" + (value == std::string::npos ? "" : line.substr(value)));
+    }
+    return args;
+}
+
+inline void ParseExperimentOptions(CommandLine& cmd, ExperimentOptions& options, int argc, char* argv[]) {
+    std::vector<std::string> args(argv, argv + argc);
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--Config=") == 0) {
+            std::vector<std::string> fileArgs = ReadConfigFile(arg.substr(9));
+            args.insert(args.begin() + 1, fileArgs.begin(), fileArgs.end());
+            break;
+        }
+    }
+    cmd.Parse(args);
+}
+
+// The link address plan from --AddressPool and --LinkPrefix
+inline AddressPlanner ExperimentAddressPlan(const ExperimentOptions& options) {
+    uint32_t base;
+    uint32_t prefix;
+    NS_ABORT_MSG_IF(!AddressPlanner::ParsePool(options.addressPool, base, prefix),
+                    "AddressPool '" << options.addressPool << "' is not a.b.c.d/len");
+    NS_ABORT_MSG_IF(options.linkPrefix != 30 && options.linkPrefix != 31, "LinkPrefix must be 30 or 31");
+    NS_ABORT_MSG_IF(prefix < 2 || prefix >= options.linkPrefix, "AddressPool " << options.addressPool
+                                                                  << " cannot hold /" << options.linkPrefix << " subnets");
+    return AddressPlanner(base, prefix, options.linkPrefix);
+}
+
+#endif // EXPERIMENT_OPTIONS_H
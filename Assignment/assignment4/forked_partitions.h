@@ -0,0 +1,134 @@
+#ifndef FORKED_PARTITIONS_H
+#define FORKED_PARTITIONS_H
+
+// Runs independent partitions of one experiment side by side inside a single
+// invocation. The caller sets up everything the partitions share (topology,
+// routing, collectors) and then each partition runs in a forked child, which
+// starts from a copy of that state, runs its own simulation and writes its
+// results to a pipe; the parent merges them as the children finish, always in
+// partition order. ns-3 keeps one Simulator per process, so a forked process
+// is the unit that can run a simulation next to another one. Plain
+// C++/POSIX, no ns-3; call it while the process has no other threads.
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// Runs run(part, out) for every part in 0..parts-1, at most 'workers' at a
+// time, and calls merge(part, in) with what each one wrote. Returns false if
+// any partition failed; the others are still merged. If a pipe or fork fails,
+// no further partitions start, and the ones already running are drained,
+// reaped and merged before returning false.
+inline bool RunForkedPartitions(uint32_t parts, uint32_t workers,
+                                const std::function<void(uint32_t, std::ostream&)>& run,
+                                const std::function<void(uint32_t, std::istream&)>& merge) {
+    struct Child {
+        pid_t pid;
+        int fd;
+        std::string output;
+    };
+    std::map<uint32_t, Child> running;
+    std::map<uint32_t, std::string> finished;   // waiting for earlier parts to merge
+    uint32_t next = 0;
+    uint32_t merged = 0;
+    bool ok = true;
+    workers = workers ? workers : 1;
+
+    while (merged < parts) {
+        while (next < parts && running.size() < workers) {
+            int fds[2];
+            if (pipe(fds) != 0) {
+                std::cerr << "Error: pipe failed for partition " << next << std::endl;
+                ok = false;
+                parts = next;
+                break;
+            }
+            std::cout.flush();
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(fds[0]);
+                std::ostringstream out;
+                try {
+                    run(next, out);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: partition " << next << ": " << e.what() << std::endl;
+                    _exit(1);
+                } catch (...) {
+                    _exit(1);
+                }
+                std::cout.flush();
+                const std::string data = out.str();
+                for (size_t written = 0; written < data.size();) {
+                    ssize_t n = write(fds[1], data.data() + written, data.size() - written);
+                    if (n <= 0) {
+                        _exit(1);
+                    }
+                    written += n;
+                }
+                _exit(0);
+            }
+            close(fds[1]);
+            if (pid < 0) {
+                close(fds[0]);
+                std::cerr << "Error: fork failed for partition " << next << std::endl;
+                ok = false;
+                parts = next;
+                break;
+            }
+            running[next++] = {pid, fds[0], std::string()};
+        }
+
+        // Drain every pipe that has data; a child whose pipe closes is done
+        std::vector<pollfd> polls;
+        std::vector<uint32_t> owners;
+        for (const auto& child : running) {
+            polls.push_back({child.second.fd, POLLIN, 0});
+            owners.push_back(child.first);
+        }
+        if (!polls.empty() && poll(polls.data(), polls.size(), -1) < 0) {
+            continue;
+        }
+        for (size_t i = 0; i < polls.size(); ++i) {
+            if (!(polls[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            Child& child = running[owners[i]];
+            char buffer[1 << 16];
+            ssize_t n = read(child.fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                child.output.append(buffer, n);
+                continue;
+            }
+            close(child.fd);
+            int status = 0;
+            waitpid(child.pid, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                std::cerr << "Error: partition " << owners[i] << " failed" << std::endl;
+                ok = false;
+                child.output.clear();
+            }
+            finished[owners[i]] = std::move(child.output);
+            running.erase(owners[i]);
+        }
+
+        for (auto it = finished.find(merged); it != finished.end(); it = finished.find(merged)) {
+            if (!it->second.empty()) {
+                std::istringstream in(it->second);
+                merge(merged, in);
+            }
+            finished.erase(it);
+            ++merged;
+        }
+    }
+    return ok;
+}
+
+#endif // FORKED_PARTITIONS_H
@@ -0,0 +1,430 @@
+#ifndef INCREMENTAL_ROUTER_H
+#define INCREMENTAL_ROUTER_H
+
+// Hop-count shortest-path routing that is kept up to date as links go down
+// and come back, without a full recomputation. Every node gets a small
+// routing protocol (IncrementalRouting) at the front of its list routing that
+// answers from a next-hop array indexed by destination node; the destination
+// node of an address comes straight from the address plan, so a lookup is
+// two array reads whatever the network size, and there is no route table to
+// search or rewrite.
+//
+// Leaf nodes (one link, typically hosts) keep no table: they send everything
+// over their link, and everybody else reaches them through the node they hang
+// off. The other ("core") nodes keep one breadth-first tree per core
+// destination, stored as the [node][destination] next-hop table (a 16-bit
+// adjacency slot each). When a link fails, only the destinations whose tree
+// used that link are recomputed; when one comes back, only those it gives a
+// strictly shorter path. Distances are not stored; they are walked along the
+// next hops when needed. What each link event cost (destinations recomputed,
+// next hops changed) is kept for the caller to write after the run.
+//
+// The nodes need list routing in their stack (the InternetStackHelper
+// default). Do not also populate global routing: its routes would be used for
+// destinations this router leaves unreachable.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "topology_builder.h"
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+class IncrementalRouter;
+
+// One link out of a node, with what a route over it needs
+struct RouteHop {
+    uint32_t link;
+    uint32_t neighbor;
+    uint16_t reverse;      // slot of the same link in the neighbour's list
+    int32_t interface;
+    Ipv4Address source;    // this end's address
+    Ipv4Address gateway;   // the neighbour's address
+    Ptr<NetDevice> device;
+};
+
+// A node's view of IncrementalRouter, installed in its list routing
+class IncrementalRouting : public Ipv4RoutingProtocol {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("IncrementalRouting")
+                                .SetParent<Ipv4RoutingProtocol>()
+                                .AddConstructor<IncrementalRouting>();
+        return tid;
+    }
+
+    void Attach(const IncrementalRouter* router, uint32_t node) {
+        m_router = router;
+        m_node = node;
+    }
+
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet>, const Ipv4Header& header, Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override {
+        Ptr<Ipv4Route> route = Lookup(header.GetDestination());
+        if (route && oif && route->GetOutputDevice() != oif) {
+            route = nullptr;
+        }
+        sockerr = route ? Socket::ERROR_NOTERROR : Socket::ERROR_NOROUTETOHOST;
+        return route;
+    }
+
+    bool RouteInput(Ptr<const Packet> packet, const Ipv4Header& header, Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb, const MulticastForwardCallback&,
+                    const LocalDeliverCallback& lcb, const ErrorCallback& ecb) override {
+        uint32_t iif = m_ipv4->GetInterfaceForDevice(idev);
+        if (m_ipv4->IsDestinationAddress(header.GetDestination(), iif)) {
+            if (lcb.IsNull()) {
+                return false;
+            }
+            lcb(packet, header, iif);
+            return true;
+        }
+        if (!m_ipv4->IsForwarding(iif)) {
+            ecb(packet, header, Socket::ERROR_NOROUTETOHOST);
+            return true;
+        }
+        Ptr<Ipv4Route> route = Lookup(header.GetDestination());
+        if (!route) {
+            return false;   // list routing reports the error if nobody else has a route
+        }
+        ucb(route, packet, header);
+        return true;
+    }
+
+    void NotifyInterfaceUp(uint32_t) override {}
+    void NotifyInterfaceDown(uint32_t) override {}
+    void NotifyAddAddress(uint32_t, Ipv4InterfaceAddress) override {}
+    void NotifyRemoveAddress(uint32_t, Ipv4InterfaceAddress) override {}
+    void SetIpv4(Ptr<Ipv4> ipv4) override { m_ipv4 = ipv4; }
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const override;
+
+    // The current next hops as host routes, one per address of every
+    // reachable node (for printing and routing_snapshot.h)
+    std::vector<Ipv4RoutingTableEntry> GetRoutes() const;
+
+private:
+    Ptr<Ipv4Route> Lookup(Ipv4Address destination) const;
+
+    const IncrementalRouter* m_router = nullptr;
+    uint32_t m_node = 0;
+    Ptr<Ipv4> m_ipv4;
+};
+
+class IncrementalRouter {
+public:
+    explicit IncrementalRouter(const Topology& topo)
+        : m_topo(topo),
+          m_n(topo.nodes.GetN()),
+          m_linkUp(topo.links.size(), true),
+          m_hops(m_n),
+          m_addresses(m_n),
+          m_core(m_n, kNone) {
+        for (uint32_t link = 0; link < topo.links.size(); ++link) {
+            uint32_t ends[2] = {topo.linkEnds[link].first, topo.linkEnds[link].second};
+            uint16_t slots[2] = {uint16_t(m_hops[ends[0]].size()), uint16_t(m_hops[ends[1]].size())};
+            for (uint32_t side = 0; side < 2; ++side) {
+                Ptr<NetDevice> device = topo.linkDevices[link].Get(side);
+                int32_t interface = topo.nodes.Get(ends[side])->GetObject<Ipv4>()->GetInterfaceForDevice(device);
+                m_hops[ends[side]].push_back({link, ends[1 - side], slots[1 - side], interface,
+                                              topo.linkInterfaces[link].GetAddress(side),
+                                              topo.linkInterfaces[link].GetAddress(1 - side), device});
+                m_addresses[ends[side]].push_back(topo.linkInterfaces[link].GetAddress(side));
+            }
+        }
+        for (uint32_t i = 0; i < m_n; ++i) {
+            NS_ABORT_MSG_IF(m_hops[i].size() >= kNoHop, "Node " << topo.names[i] << " has too many links");
+            if (!IsLeaf(i)) {
+                m_core[i] = m_coreNodes.size();
+                m_coreNodes.push_back(i);
+            }
+        }
+        m_next.assign(m_coreNodes.size(), std::vector<uint16_t>(m_coreNodes.size(), kNoHop));
+        m_seen.assign(m_n, 0);
+
+        for (uint32_t i = 0; i < m_n; ++i) {
+            Ptr<Ipv4> ipv4 = topo.nodes.Get(i)->GetObject<Ipv4>();
+            Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol());
+            NS_ABORT_MSG_IF(!list, "IncrementalRouter needs list routing on node " << topo.names[i]);
+            Ptr<IncrementalRouting> routing = CreateObject<IncrementalRouting>();
+            routing->Attach(this, i);
+            list->AddRoutingProtocol(routing, 10);   // ahead of static (0) and global (-10)
+            m_ipv4.push_back(ipv4);
+        }
+    }
+
+    // Computes every tree; call once before the run
+    void Populate() {
+        for (uint32_t d = 0; d < m_coreNodes.size(); ++d) {
+            Recompute(d);
+        }
+    }
+
+    // Schedules link 'link' to go down (up = false) or come back at 'when'
+    void ScheduleLinkChange(Time when, uint32_t link, bool up) {
+        Simulator::Schedule(when - Simulator::Now(), &IncrementalRouter::SetLink, this, link, up);
+    }
+
+    // "<a>-<b>@<seconds>[:up|:down]" entries, comma separated; down by default
+    void ScheduleLinkEvents(const std::string& events) {
+        std::stringstream list(events);
+        for (std::string event; std::getline(list, event, ',');) {
+            size_t at = event.find('@');
+            size_t dash = event.find('-');
+            size_t colon = event.find(':', at);
+            NS_ABORT_MSG_IF(at == std::string::npos || dash == std::string::npos || dash > at,
+                            "Bad link event '" << event << "', expected <a>-<b>@<seconds>[:up|:down]");
+            std::string a = event.substr(0, dash);
+            std::string b = event.substr(dash + 1, at - dash - 1);
+            double seconds = std::stod(event.substr(at + 1, colon == std::string::npos ? std::string::npos
+                                                                                      : colon - at - 1));
+            bool up = colon != std::string::npos && event.substr(colon + 1) == "up";
+            ScheduleLinkChange(Seconds(seconds), FindLink(a, b), up);
+        }
+    }
+
+    void SetLink(uint32_t link, bool up) {
+        if (m_linkUp[link] == up) {
+            return;
+        }
+        m_linkUp[link] = up;
+        uint32_t u = m_topo.linkEnds[link].first;
+        uint32_t v = m_topo.linkEnds[link].second;
+        for (uint32_t side = 0; side < 2; ++side) {
+            uint32_t node = side == 0 ? u : v;
+            int32_t interface = m_ipv4[node]->GetInterfaceForDevice(m_topo.linkDevices[link].Get(side));
+            if (up) {
+                m_ipv4[node]->SetUp(interface);
+            } else {
+                m_ipv4[node]->SetDown(interface);
+            }
+        }
+
+        // A leaf's link carries no transit traffic; lookups check it directly
+        uint32_t recomputed = 0;
+        uint32_t changed = 0;
+        if (m_core[u] != kNone && m_core[v] != kNone) {
+            uint32_t cu = m_core[u];
+            uint32_t cv = m_core[v];
+            for (uint32_t d = 0; d < m_coreNodes.size(); ++d) {
+                bool affected = up ? Improves(d, cu, cv) || Improves(d, cv, cu)
+                                   : UsesLink(cu, d, link) || UsesLink(cv, d, link);
+                if (affected) {
+                    changed += Recompute(d);
+                    ++recomputed;
+                }
+            }
+        }
+        m_changes.push_back({Simulator::Now().GetSeconds(), link, up, recomputed, changed});
+    }
+
+    // What each link event cost, in event order
+    struct LinkChange {
+        double time;
+        uint32_t link;
+        bool up;
+        uint32_t recomputed;   // destinations whose tree was rebuilt
+        uint32_t changed;      // next hops that moved
+    };
+
+    const std::vector<LinkChange>& GetLinkChanges() const { return m_changes; }
+
+    // One line per link event, after the run
+    bool WriteLinkChanges(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        for (const LinkChange& change : m_changes) {
+            file << change.time << "s: link " << m_topo.LinkName(change.link) << (change.up ? " up" : " down")
+                 << ", recomputed " << change.recomputed << " of " << m_coreNodes.size() << " destinations, "
+                 << change.changed << " next hops changed\n";
+        }
+        return file.good();
+    }
+
+    // The link 'node' sends towards topology node 'dest' on, nullptr if none
+    const RouteHop* NextHop(uint32_t node, uint32_t dest) const {
+        if (node == dest || node >= m_n || dest >= m_n) {
+            return nullptr;
+        }
+        if (m_core[node] == kNone) {
+            const RouteHop& hop = m_hops[node][0];
+            return m_linkUp[hop.link] ? &hop : nullptr;
+        }
+        uint32_t target = dest;
+        if (m_core[dest] == kNone) {
+            const RouteHop& leafLink = m_hops[dest][0];
+            if (!m_linkUp[leafLink.link]) {
+                return nullptr;
+            }
+            if (leafLink.neighbor == node) {
+                return &m_hops[node][leafLink.reverse];
+            }
+            target = leafLink.neighbor;
+        }
+        uint16_t slot = m_next[m_core[node]][m_core[target]];
+        return slot == kNoHop ? nullptr : &m_hops[node][slot];
+    }
+
+    // Topology node owning 'address', NodeAliasTable::kUnknown if none
+    uint32_t NodeOf(Ipv4Address address) const { return m_topo.aliases.ForAddress(address); }
+
+    uint32_t GetN() const { return m_n; }
+    const std::string& Name(uint32_t node) const { return m_topo.names[node]; }
+    const std::vector<Ipv4Address>& Addresses(uint32_t node) const { return m_addresses[node]; }
+
+private:
+    static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t kUnreachable = std::numeric_limits<uint32_t>::max();
+    static constexpr uint16_t kNoHop = std::numeric_limits<uint16_t>::max();
+
+    // One link, to a node that has more than that one
+    bool IsLeaf(uint32_t node) const {
+        return m_hops[node].size() == 1 && m_hops[m_hops[node][0].neighbor].size() > 1;
+    }
+
+    bool UsesLink(uint32_t c, uint32_t d, uint32_t link) const {
+        uint16_t slot = m_next[c][d];
+        return slot != kNoHop && m_hops[m_coreNodes[c]][slot].link == link;
+    }
+
+    // Hops from core node c to core destination d along the current next hops
+    uint32_t Hops(uint32_t c, uint32_t d) const {
+        uint32_t hops = 0;
+        while (c != d) {
+            uint16_t slot = m_next[c][d];
+            if (slot == kNoHop || ++hops > m_coreNodes.size()) {
+                return kUnreachable;
+            }
+            c = m_core[m_hops[m_coreNodes[c]][slot].neighbor];
+        }
+        return hops;
+    }
+
+    // Whether the (now up) edge from core node x to y shortens y's path to d
+    bool Improves(uint32_t d, uint32_t x, uint32_t y) const {
+        uint32_t hx = Hops(x, d);
+        return hx != kUnreachable && hx + 1 < Hops(y, d);
+    }
+
+    uint32_t FindLink(const std::string& a, const std::string& b) const {
+        uint32_t x = m_topo.Index(a);
+        uint32_t y = m_topo.Index(b);
+        for (const RouteHop& hop : m_hops[x]) {
+            if (hop.neighbor == y) {
+                return hop.link;
+            }
+        }
+        NS_ABORT_MSG("No link between " << a << " and " << b);
+        return 0;
+    }
+
+    // Rebuilds the tree towards core destination 'd' over the core links that
+    // are up and stores it as every core node's next hop. Returns how many
+    // next hops changed.
+    uint32_t Recompute(uint32_t d) {
+        uint32_t dest = m_coreNodes[d];
+        ++m_stamp;
+        std::vector<uint16_t> next(m_coreNodes.size(), kNoHop);
+        m_frontier.clear();
+        m_seen[dest] = m_stamp;
+        m_frontier.push_back(dest);
+        while (!m_frontier.empty()) {
+            uint32_t x = m_frontier.front();
+            m_frontier.pop_front();
+            for (const RouteHop& hop : m_hops[x]) {
+                uint32_t y = hop.neighbor;
+                if (m_linkUp[hop.link] && m_core[y] != kNone && m_seen[y] != m_stamp) {
+                    m_seen[y] = m_stamp;
+                    next[m_core[y]] = hop.reverse;   // y reaches d through x
+                    m_frontier.push_back(y);
+                }
+            }
+        }
+
+        uint32_t changed = 0;
+        for (uint32_t c = 0; c < m_coreNodes.size(); ++c) {
+            if (c != d && next[c] != m_next[c][d]) {
+                m_next[c][d] = next[c];
+                ++changed;
+            }
+        }
+        return changed;
+    }
+
+    const Topology& m_topo;
+    uint32_t m_n;
+    std::vector<bool> m_linkUp;
+    std::vector<std::vector<RouteHop>> m_hops;           // per node, one per link
+    std::vector<std::vector<Ipv4Address>> m_addresses;   // every address of each node
+    std::vector<uint32_t> m_core;                        // node -> core index, kNone for leaves
+    std::vector<uint32_t> m_coreNodes;                   // core index -> node
+    std::vector<std::vector<uint16_t>> m_next;           // [core node][core dest] slot in m_hops, kNoHop if none
+    std::vector<uint32_t> m_seen;                        // BFS marks, == m_stamp when visited
+    uint32_t m_stamp = 0;
+    std::deque<uint32_t> m_frontier;
+    std::vector<Ptr<Ipv4>> m_ipv4;
+    std::vector<LinkChange> m_changes;
+};
+
+inline Ptr<Ipv4Route> IncrementalRouting::Lookup(Ipv4Address destination) const {
+    if (!m_router || destination.IsMulticast() || destination.IsBroadcast()) {
+        return nullptr;
+    }
+    const RouteHop* hop = m_router->NextHop(m_node, m_router->NodeOf(destination));
+    if (!hop) {
+        return nullptr;
+    }
+    Ptr<Ipv4Route> route = Create<Ipv4Route>();
+    route->SetDestination(destination);
+    route->SetSource(hop->source);
+    route->SetGateway(hop->gateway);
+    route->SetOutputDevice(hop->device);
+    return route;
+}
+
+inline std::vector<Ipv4RoutingTableEntry> IncrementalRouting::GetRoutes() const {
+    std::vector<Ipv4RoutingTableEntry> routes;
+    for (uint32_t dest = 0; m_router && dest < m_router->GetN(); ++dest) {
+        const RouteHop* hop = m_router->NextHop(m_node, dest);
+        if (hop) {
+            for (const Ipv4Address& address : m_router->Addresses(dest)) {
+                routes.push_back(Ipv4RoutingTableEntry::CreateHostRouteTo(address, hop->gateway, hop->interface));
+            }
+        }
+    }
+    return routes;
+}
+
+inline void IncrementalRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const {
+    std::ostream& os = *stream->GetStream();
+    os << "Node: " << (m_router ? m_router->Name(m_node) : std::string("?")) << ", Time: " << Now().As(unit)
+       << ", IncrementalRouting table" << std::endl;
+    for (const Ipv4RoutingTableEntry& route : GetRoutes()) {
+        os << route << std::endl;
+    }
+}
+
+// Routing for an experiment: plain global routing, or with link events
+// (see ScheduleLinkEvents) the incremental router. Call after the topology is
+// built; keep the returned router alive for the whole run.
+inline std::unique_ptr<IncrementalRouter> SetUpRouting(const Topology& topo, const std::string& linkEvents) {
+    if (linkEvents.empty()) {
+        Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+        return nullptr;
+    }
+    std::unique_ptr<IncrementalRouter> router(new IncrementalRouter(topo));
+    router->Populate();
+    router->ScheduleLinkEvents(linkEvents);
+    return router;
+}
+
+#endif // INCREMENTAL_ROUTER_H
@@ -8,297 +8,143 @@
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/error-model.h" 
+#include "topology_builder.h"
+#include "topology_generator.h"
+#include "experiment_options.h"
+#include "run_profiler.h"
+#include "incremental_router.h"
+#include "error_models.h"
+#include "traffic_matrix.h"
+#include "traffic_generator.h"
+#include "counter_rng.h"
+#include "routing_snapshot.h"
+#include <cstdlib>
 #include <map>
 #include <utility>
 #include <string>
 #include <iostream>
-#include <random>
 #include <fstream>
 #include <iomanip>
+#include <sstream>
 using namespace ns3;
-// Declare the traffic matrix
-std::map<std::pair<std::string, std::string>, uint32_t> trafficMatrix;
-std::map<Ipv4Address, std::string> ipToNodeName;
+// Declare the traffic matrix (rows = source host, columns = destination host)
+TrafficMatrix trafficMatrix;
 //! Function to update the traffic matrix
 // Function to print traffic matrix in a tabular format and output it to a file
-void PrintTrafficMatrix(const std::map<std::pair<std::string, std::string>, uint32_t>& trafficMatrix) {
-    std::ofstream outputFile("traffic_matrix.txt");
-    // Get the unique set of nodes (sources and destinations)
-    std::set<std::string> nodes;
-    for (const auto& entry : trafficMatrix) {
-        nodes.insert(entry.first.first);  // Source node
-        nodes.insert(entry.first.second); // Destination node
-    }
-    // Convert set of nodes to a vector for indexing
-    std::vector<std::string> nodeList(nodes.begin(), nodes.end());
-    // Create a lookup for node indices
-    std::map<std::string, int> nodeIndex;
-    for (size_t i = 0; i < nodeList.size(); ++i) {
-        nodeIndex[nodeList[i]] = i;
-    }
-    // Initialize the matrix
-    std::vector<std::vector<uint32_t>> matrix(nodeList.size(), std::vector<uint32_t>(nodeList.size(), 0));
-    // Fill the matrix
-    for (const auto& entry : trafficMatrix) {
-        const std::string& src = entry.first.first;
-        const std::string& dst = entry.first.second;
-        matrix[nodeIndex[src]][nodeIndex[dst]] = entry.second;
-    }
-    // Print the header row
-    std::cout << "Traffic Matrix:" << std::endl;
-    std::cout << std::setw(5) << " " << " ";
-    outputFile << "Traffic Matrix:" << std::endl;
-    outputFile << std::setw(5) << " " << " ";
-    for (const auto& node : nodeList) {
-        std::cout << std::setw(5) << node << " ";
-        outputFile << std::setw(5) << node << " ";
-    }
-    std::cout << std::endl;
-    outputFile << std::endl;
-    // Print the matrix rows
-    for (size_t i = 0; i < nodeList.size(); ++i) {
-        std::cout << std::setw(5) << nodeList[i] << " ";
-        outputFile << std::setw(5) << nodeList[i] << " ";
-        for (size_t j = 0; j < nodeList.size(); ++j) {
-            std::cout << std::setw(5) << matrix[i][j] << " ";
-            outputFile << std::setw(5) << matrix[i][j] << " ";
-        }
-        std::cout << std::endl;
-        outputFile << std::endl;
-    }
+void PrintTrafficMatrix(const TrafficMatrix& trafficMatrix, const std::string& outputDir) {
+    std::ofstream outputFile(outputDir + "/traffic_matrix.txt");
+    trafficMatrix.WriteText(std::cout, "Traffic Matrix:", " ", 5, " ");
+    trafficMatrix.WriteText(outputFile, "Traffic Matrix:", " ", 5, " ");
     outputFile.close();
+    trafficMatrix.WriteCsv(outputDir + "/traffic_matrix.csv", "load");
+    trafficMatrix.WriteBinary(outputDir + "/traffic_matrix.bin");
     std::cout << "Traffic matrix has been written to 'traffic_matrix.txt'." << std::endl;
 }
-void GenerateTrafficMatrix(const std::vector<std::string>& hosts, double lambda) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::poisson_distribution<> poissonDist(lambda);
-    for (const auto& src : hosts) {
-        for (const auto& dst : hosts) {
+// Each cell is its own counter-based draw keyed by the ns-3 seed and run
+// (--RngSeed / --RngRun), so the same run always yields the same matrix.
+void GenerateTrafficMatrix(const std::vector<std::string>& hosts, double lambda, uint64_t stream) {
+    CounterRng rng(RngSeedManager::GetSeed(), RngSeedManager::GetRun(), stream);
+    trafficMatrix = TrafficMatrix(hosts);
+    for (uint32_t src = 0; src < hosts.size(); ++src) {
+        for (uint32_t dst = 0; dst < hosts.size(); ++dst) {
             if (src != dst) {
-                uint32_t trafficLoad = poissonDist(gen); // Poisson-distributed traffic load
-                trafficMatrix[std::make_pair(src, dst)] = trafficLoad;
+                trafficMatrix.At(src, dst) = rng.Poisson(uint64_t(src) * hosts.size() + dst, lambda); // Poisson-distributed traffic load
             }
         }
     }
 }
-void PopulateIpToNodeNameMapping(NodeContainer hosts, NodeContainer routers, Ipv4InterfaceContainer interfaces) {
-    // Add host names
-    std::vector<std::string> hostNames = {"A", "B", "C", "D", "E", "F", "G"};
-    for (uint32_t i = 0; i < hosts.GetN(); ++i) {
-        Ptr<Ipv4> ipv4 = hosts.Get(i)->GetObject<Ipv4>();
-        for (uint32_t j = 0; j < ipv4->GetNInterfaces(); ++j) {
-            Ipv4Address ip = ipv4->GetAddress(j, 0).GetLocal();
-            ipToNodeName[ip] = hostNames[i];
-        }
-    }
-    // Add router names
-    std::vector<std::string> routerNames = {"R1", "R2", "R3", "R4"};
-    for (uint32_t i = 0; i < routers.GetN(); ++i) {
-        Ptr<Ipv4> ipv4 = routers.Get(i)->GetObject<Ipv4>();
-        for (uint32_t j = 0; j < ipv4->GetNInterfaces(); ++j) {
-            Ipv4Address ip = ipv4->GetAddress(j, 0).GetLocal();
-            ipToNodeName[ip] = routerNames[i];
-        }
-    }
-}
 NS_LOG_COMPONENT_DEFINE("CustomNetworkSimulation");
-// Call this after assigning IP addresses
-// PopulateIpToNodeNameMapping(hosts, routers, address.Assign(routerDevices));
-// Updated PrintRoutingTable function
-void PrintRoutingTable(Ptr<Node> node, std::ostream &os, const std::map<Ipv4Address, std::string> &ipToNodeName) {
-    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-    Ptr<Ipv4RoutingProtocol> routingProtocol = ipv4->GetRoutingProtocol();
-    Ptr<Ipv4GlobalRouting> globalRouting = DynamicCast<Ipv4GlobalRouting>(routingProtocol);
-    if (globalRouting != nullptr) {
-        uint32_t numRoutes = globalRouting->GetNRoutes();
-        os << "Routing table for node " 
-           << ipToNodeName.at(ipv4->GetAddress(1, 0).GetLocal()) // Get the node's name
-           << " (Node ID: " << node->GetId() << "):" << std::endl;
-        for (uint32_t i = 0; i < numRoutes; ++i) {
-            Ipv4RoutingTableEntry route = globalRouting->GetRoute(i);
-            // Destination name
-            std::ostringstream destStream;
-            if (ipToNodeName.count(route.GetDest())) {
-                destStream << ipToNodeName.at(route.GetDest());
-            } else {
-                route.GetDest().Print(destStream);
-            }
-            std::string destName = destStream.str();
-            // Gateway name
-            std::ostringstream gatewayStream;
-            if (ipToNodeName.count(route.GetGateway())) {
-                gatewayStream << ipToNodeName.at(route.GetGateway());
-            } else {
-                route.GetGateway().Print(gatewayStream);
-            }
-            std::string gatewayName = gatewayStream.str();
-            // Print the routing entry
-            os << "  Destination: " << destName
-               << ", Gateway: " << gatewayName
-               << ", Interface: " << route.GetInterface()
-               << std::endl;
-        }
-        os << std::endl;
-    } else {
-        os << "Error: Routing protocol on node " << node->GetId() << " is not global routing!" << std::endl;
-    }
-}
 int main(int argc, char *argv[]) {
+    ExperimentOptions options;
+    options.maxPackets = 2;
+    options.interval = 2.0;
+    options.packetSize = 512;
+    double lambda = 80.0;
+    double loadScale = 0.01;
+    std::string routeSnapshots = "0";
     CommandLine cmd;
-    cmd.Parse(argc, argv);
+    AddExperimentOptions(cmd, options);
+    cmd.AddValue("Lambda", "Mean of the Poisson traffic load per host pair", lambda);
+    cmd.AddValue("LoadScale", "Packets per second sent for each unit of traffic load", loadScale);
+    cmd.AddValue("RouteSnapshots", "Comma-separated times (seconds) to capture the routing tables", routeSnapshots);
+    ParseExperimentOptions(cmd, options, argc, argv);
     Time::SetResolution(Time::NS);
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
     
     // Enable logging for debugging
-    LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
-    LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
-    // Create 7 hosts (A-G) and 4 routers (R1-R4)
-    NodeContainer hosts;
-    hosts.Create(7);
-    NodeContainer routers;
-    routers.Create(4);
-       std::vector<std::string> hostNames = {"A", "B", "C", "D", "E", "F", "G"};
-    InternetStackHelper stack;
-    Ipv4GlobalRoutingHelper globalRouting; // Ensure global routing is used
-stack.SetRoutingHelper(globalRouting);
-    stack.Install(hosts);
-    stack.Install(routers);
-    // Create point-to-point helper for links
-    PointToPointHelper p2p;
-    // Define link parameters based on the image topology
-    // Connect hosts to their respective routers
-    NetDeviceContainer hostDevices[7];
-    NetDeviceContainer routerDevices;
-    // Host-to-Router links with capacities from Table 3
-    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // A - R1
-    hostDevices[0] = p2p.Install(NodeContainer(hosts.Get(0), routers.Get(0)));
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // B - R1
-    hostDevices[1] = p2p.Install(NodeContainer(hosts.Get(1), routers.Get(0)));
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // C - R3
-    hostDevices[2] = p2p.Install(NodeContainer(hosts.Get(2), routers.Get(2)));
-    p2p.SetDeviceAttribute("DataRate", StringValue("2Mbps")); // D - R3
-    hostDevices[3] = p2p.Install(NodeContainer(hosts.Get(3), routers.Get(2)));
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // E - R2
-    hostDevices[4] = p2p.Install(NodeContainer(hosts.Get(4), routers.Get(1)));
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // F - R2
-    hostDevices[5] = p2p.Install(NodeContainer(hosts.Get(5), routers.Get(1)));
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // G - R4
-    hostDevices[6] = p2p.Install(NodeContainer(hosts.Get(6), routers.Get(3)));
-    // Router-to-Router links with capacities from Table 3
-    p2p.SetDeviceAttribute("DataRate", StringValue("3Mbps")); // R1 - R2
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(0), routers.Get(1))));
-    p2p.SetDeviceAttribute("DataRate", StringValue("2.5Mbps")); // R1 - R3
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(0), routers.Get(2))));
-    p2p.SetDeviceAttribute("DataRate", StringValue("1.5Mbps")); // R3 - R4
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(2), routers.Get(3))));
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // R2 - R4
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(1), routers.Get(3))));
-    // Create an Error Model
-Ptr<RateErrorModel> errorModel = CreateObject<RateErrorModel>();
-errorModel->SetAttribute("ErrorRate", DoubleValue(0.01)); // 1% packet drop rate
-// Apply the error model to each device
-hostDevices[0].Get(1)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); // A - R1
-hostDevices[1].Get(1)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); // B - R1
-hostDevices[2].Get(1)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); // C - R3
-hostDevices[3].Get(1)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); // D - R3
-hostDevices[4].Get(1)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); // E - R2
-hostDevices[5].Get(1)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); // F - R2
-hostDevices[6].Get(1)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); // G - R4
-routerDevices.Get(0)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); // R1 - R2
-routerDevices.Get(1)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); // R1 - R3
-routerDevices.Get(2)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); // R3 - R4
-routerDevices.Get(3)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); // R2 - R4
-    // Assign IP addresses to all links
-    Ipv4AddressHelper address;
-    std::string baseIp = "10.1.";
-    for (uint32_t i = 0; i < 7; ++i) {
-        address.SetBase(Ipv4Address((baseIp + std::to_string(i) + ".0").c_str()), "255.255.255.0");
-        address.Assign(hostDevices[i]);
+    if (options.logPackets) {
+        LogComponentEnable("PacketSink", LOG_LEVEL_INFO);
     }
-    for (uint32_t i = 0; i < routerDevices.GetN(); ++i) {
-        address.SetBase(Ipv4Address((baseIp + std::to_string(i + 7) + ".0").c_str()), "255.255.255.0");
-        address.Assign(routerDevices.Get(i));
+    // Build the 7-host / 4-router network (A-G, R1-R4) from the Table 3 link table
+    std::vector<std::string> hostNames = DefaultHostNames();
+    std::vector<std::string> routerNames = DefaultRouterNames();
+    std::vector<LinkSpec> links = DefaultLinkTable();
+    if (!options.linkTable.empty()) {
+        LoadLinkTable(options.linkTable, hostNames, routerNames, links);
     }
-    // Set up UDP Echo server on Host A (host 0)
-    UdpEchoServerHelper echoServer(9);
-    ApplicationContainer serverApps = echoServer.Install(hosts.Get(0));
-    serverApps.Start(Seconds(1.0));
-    serverApps.Stop(Seconds(10.0));
-    // Enable global routing
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
-    // Set up UDP Echo clients on remaining hosts (B-G)
-    for (uint32_t i = 1; i < 7; ++i) {
-        UdpEchoClientHelper echoClient(Ipv4Address("10.1.0.1"), 9); // Send to Host A
-        echoClient.SetAttribute("MaxPackets", UintegerValue(2));
-        echoClient.SetAttribute("Interval", TimeValue(Seconds(2.0)));
-        echoClient.SetAttribute("PacketSize", UintegerValue(512));
-        ApplicationContainer clientApps = echoClient.Install(hosts.Get(i));
-        clientApps.Start(Seconds(2.0 + i));
-        clientApps.Stop(Seconds(10.0));
+    if (!options.topology.empty()) {
+        GenerateTopology(options.topology, hostNames, routerNames, links);
     }
+    InternetStackHelper stack;
+    Topology topo = BuildTopology(hostNames, routerNames, links, stack, ExperimentAddressPlan(options));
+    NodeContainer hosts = topo.hosts;
+    NodeContainer routers = topo.routers;
+    // An independent error model per link, from the link table's loss column
+    // (ErrorRate on links without one), each on its own RNG streams
+    InstallErrorModels(topo, options.errorRate);
+    // Global routing, or the incremental router when links fail during the run
+    std::unique_ptr<IncrementalRouter> router = SetUpRouting(topo, options.linkEvents);
+    // Poisson traffic between every host pair, at the rates of the generated matrix
+    GenerateTrafficMatrix(hostNames, lambda, 0);
+    InstallMatrixTraffic(topo, trafficMatrix, loadScale, options.packetSize, 9,
+                         Seconds(2.0), Seconds(options.appStopTime), 1);
     
-// Routing table tracking snippet
-for (uint32_t i = 0; i < routers.GetN(); ++i) {
-    Ptr<Node> router = routers.Get(i);
-    Ptr<Ipv4> ipv4 = router->GetObject<Ipv4>();
-    Ptr<Ipv4RoutingProtocol> routingProtocol = ipv4->GetRoutingProtocol();
-    Ptr<Ipv4GlobalRouting> globalRouting = DynamicCast<Ipv4GlobalRouting>(routingProtocol);
-    if (globalRouting!= nullptr) {
-        uint32_t numRoutes = globalRouting->GetNRoutes();
-        std::cout << "Routing table for Router R" << (i + 1) << ":" << std::endl;
-        for (uint32_t j = 0; j < numRoutes; ++j) {
-            Ipv4RoutingTableEntry route = globalRouting->GetRoute(j);
-            std::cout << "  Destination: " << route.GetDest()
-                      << ", Next Hop: " << route.GetGateway()
-                      << ", Interface: " << route.GetInterface() << std::endl;
+    // Routing tables at each --RouteSnapshots time; only the changes are written
+    RoutingSnapshotter routingSnapshots(topo, options.outputDir + "/routing_changes.txt");
+    if (!routingSnapshots.IsOpen()) {
+        std::cerr << "Error: Could not open routing_changes.txt for writing!" << std::endl;
+        return 1;
+    }
+    std::stringstream snapshotTimes(routeSnapshots);
+    for (std::string time; std::getline(snapshotTimes, time, ',');) {
+        if (time.empty()) {
+            continue;   // stray comma
         }
-        std::cout << std::endl;
-    } else {
-        std::cerr << "Error: Routing protocol is not global routing!" << std::endl;
+        char* end = nullptr;
+        double seconds = std::strtod(time.c_str(), &end);
+        NS_ABORT_MSG_IF(end != time.c_str() + time.size() || !(seconds >= 0),
+                        "RouteSnapshots time '" << time << "' is not a non-negative number of seconds");
+        routingSnapshots.ScheduleAt(Seconds(seconds));
     }
-}
     // Create NetAnim animation
     AnimationInterface anim("custom_network_topology.xml");
     anim.EnableIpv4RouteTracking("route-tracking.xml", Seconds(1.0), Seconds(10.0), Seconds(5.0));
-    // Set custom positions for hosts
-    anim.SetConstantPosition(hosts.Get(0), 10, 10); // Host A
-    anim.SetConstantPosition(hosts.Get(1), 20, 10); // Host B
-    anim.SetConstantPosition(hosts.Get(2), 30, 40); // Host C
-    anim.SetConstantPosition(hosts.Get(3), 40, 40); // Host D
-    anim.SetConstantPosition(hosts.Get(4), 30, 10); // Host E
-    anim.SetConstantPosition(hosts.Get(5), 40, 10); // Host F
-    anim.SetConstantPosition(hosts.Get(6), 10, 40); // Host G
-    // Set custom positions for routers
-    anim.SetConstantPosition(routers.Get(0), 20, 20); // Router R1
-    anim.SetConstantPosition(routers.Get(1), 40, 20); // Router R2
-    anim.SetConstantPosition(routers.Get(2), 40, 30); // Router R3
-    anim.SetConstantPosition(routers.Get(3), 20, 30); // Router R4
-    // Set custom names for routers
-    anim.UpdateNodeDescription(routers.Get(0), "R1");
-    anim.UpdateNodeDescription(routers.Get(1), "R2");
-    anim.UpdateNodeDescription(routers.Get(2), "R3");
-    anim.UpdateNodeDescription(routers.Get(3), "R4");
-    // Set custom names for hosts
-    anim.UpdateNodeDescription(hosts.Get(0), "A");
-    anim.UpdateNodeDescription(hosts.Get(1), "B");
-    anim.UpdateNodeDescription(hosts.Get(2), "C");
-    anim.UpdateNodeDescription(hosts.Get(3), "D");
-    anim.UpdateNodeDescription(hosts.Get(4), "E");
-    anim.UpdateNodeDescription(hosts.Get(5), "F");
-    anim.UpdateNodeDescription(hosts.Get(6), "G");
-    PopulateIpToNodeNameMapping(hosts, routers, address.Assign(routerDevices));
-    for (uint32_t i = 0; i < routers.GetN(); ++i) {
-    Ptr<Node> router = routers.Get(i);
-    PrintRoutingTable(router, std::cout, ipToNodeName);
-}
-   GenerateTrafficMatrix(hostNames,80.0);
-    // PrintTrafficMatrix(/trafficMatrix);
+    // Set custom positions for the built-in topology's hosts and routers
+    if (options.linkTable.empty() && options.topology.empty()) {
+        anim.SetConstantPosition(hosts.Get(0), 10, 10); // Host A
+        anim.SetConstantPosition(hosts.Get(1), 20, 10); // Host B
+        anim.SetConstantPosition(hosts.Get(2), 30, 40); // Host C
+        anim.SetConstantPosition(hosts.Get(3), 40, 40); // Host D
+        anim.SetConstantPosition(hosts.Get(4), 30, 10); // Host E
+        anim.SetConstantPosition(hosts.Get(5), 40, 10); // Host F
+        anim.SetConstantPosition(hosts.Get(6), 10, 40); // Host G
+        anim.SetConstantPosition(routers.Get(0), 20, 20); // Router R1
+        anim.SetConstantPosition(routers.Get(1), 40, 20); // Router R2
+        anim.SetConstantPosition(routers.Get(2), 40, 30); // Router R3
+        anim.SetConstantPosition(routers.Get(3), 20, 30); // Router R4
+    }
+    // Set custom names for hosts and routers
+    for (uint32_t i = 0; i < topo.nodes.GetN(); ++i) {
+        anim.UpdateNodeDescription(topo.nodes.Get(i), topo.names[i]);
+    }
     // Run the simulation
-    Simulator::Stop(Seconds(60.0));
+    Simulator::Stop(Seconds(options.stopTime));
+    RunProfiler profiler(topo, options.profile);
     Simulator::Run();
-    PrintTrafficMatrix(trafficMatrix);
+    profiler.Finish(std::cout);
+    if (router && !router->WriteLinkChanges(options.outputDir + "/link_changes.txt")) {
+        std::cerr << "Error writing link_changes.txt!" << std::endl;
+    }
+    PrintTrafficMatrix(trafficMatrix, options.outputDir);
     Simulator::Destroy();
     return 0;
 }
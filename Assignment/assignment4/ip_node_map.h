@@ -0,0 +1,63 @@
+#ifndef IP_NODE_MAP_H
+#define IP_NODE_MAP_H
+
+// Address -> node lookup built once from what is actually installed: every
+// address of every IPv4 interface of every topology node (loopback aside),
+// sorted into one flat array and found by binary search. It covers router
+// and host interfaces alike, whatever the addressing, and an address it has
+// never seen comes back as kUnknown ("Unknown" by name), never as an empty
+// name. Node ids are topology indexes, so host ids are also matrix rows.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "topology_builder.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+class IpNodeMap {
+public:
+    static constexpr uint32_t kUnknown = 0xffffffff;
+
+    explicit IpNodeMap(const Topology& topo) : m_names(topo.names) {
+        for (uint32_t i = 0; i < topo.nodes.GetN(); ++i) {
+            Ptr<Ipv4> ipv4 = topo.nodes.Get(i)->GetObject<Ipv4>();
+            if (!ipv4) {
+                continue;
+            }
+            for (uint32_t interface = 0; interface < ipv4->GetNInterfaces(); ++interface) {
+                for (uint32_t j = 0; j < ipv4->GetNAddresses(interface); ++j) {
+                    Ipv4Address local = ipv4->GetAddress(interface, j).GetLocal();
+                    if (!local.IsLocalhost()) {
+                        m_entries.emplace_back(local.Get(), i);
+                    }
+                }
+            }
+        }
+        std::sort(m_entries.begin(), m_entries.end());
+    }
+
+    // Topology index of the node owning 'address', kUnknown if none does
+    uint32_t Find(Ipv4Address address) const {
+        auto it = std::lower_bound(m_entries.begin(), m_entries.end(), std::make_pair(address.Get(), 0u));
+        return it != m_entries.end() && it->first == address.Get() ? it->second : kUnknown;
+    }
+
+    const std::string& Name(Ipv4Address address) const {
+        static const std::string unknown = "Unknown";
+        uint32_t node = Find(address);
+        return node == kUnknown ? unknown : m_names[node];
+    }
+
+    size_t GetNAddresses() const { return m_entries.size(); }
+
+private:
+    std::vector<std::string> m_names;
+    std::vector<std::pair<uint32_t, uint32_t>> m_entries;   // (address, node), sorted
+};
+
+#endif // IP_NODE_MAP_H
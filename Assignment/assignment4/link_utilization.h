@@ -0,0 +1,195 @@
+#ifndef LINK_UTILIZATION_H
+#define LINK_UTILIZATION_H
+
+// Per-direction utilization of every point-to-point link, counted from the
+// devices' PhyTxEnd trace as packets finish transmitting. Besides the mean
+// over the run, each direction keeps a sliding window made of 10 sub-bins and
+// records its peak windowed utilization and the first time that window went
+// over the saturation threshold. The report ranks directions by how early
+// they saturated, then by peak and mean utilization, so the bottleneck is on
+// top. Directions are numbered like NodeAliasTable interfaces: link * 2 + side.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+#include "distributed.h"
+#include "run_profiler.h"
+#include "topology_builder.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+class LinkUtilizationMonitor {
+public:
+    LinkUtilizationMonitor(const Topology& topo, Time window, double saturationThreshold = 0.9)
+        : m_binNs(std::max<int64_t>(1, window.GetNanoSeconds() / kBins)),
+          m_threshold(saturationThreshold),
+          m_startNs(Simulator::Now().GetNanoSeconds()),
+          m_endNs(m_startNs),
+          m_directions(topo.links.size() * 2) {
+        for (uint32_t link = 0; link < topo.links.size(); ++link) {
+            for (uint32_t side = 0; side < 2; ++side) {
+                Direction& d = m_directions[link * 2 + side];
+                d.name = side == 0 ? topo.links[link].a + " -> " + topo.links[link].b
+                                   : topo.links[link].b + " -> " + topo.links[link].a;
+                d.bin = m_startNs / m_binNs;
+                Ptr<PointToPointNetDevice> device =
+                    DynamicCast<PointToPointNetDevice>(topo.linkDevices[link].Get(side));
+                if (device) {
+                    DataRateValue rate;
+                    device->GetAttribute("DataRate", rate);
+                    d.bitRate = rate.Get().GetBitRate();
+                    device->TraceConnectWithoutContext(
+                        "PhyTxEnd", MakeBoundCallback(&LinkUtilizationMonitor::TxEnd, this, link * 2 + side));
+                }
+            }
+        }
+    }
+
+    // Closes the last windows at 'end'; call once after Simulator::Run()
+    void Finish(Time end) {
+        m_endNs = end.GetNanoSeconds();
+        for (auto& d : m_directions) {
+            Advance(d, m_endNs / m_binNs);
+        }
+    }
+
+    // Combines the ranks of a distributed run into rank 0, after Finish(). A
+    // direction only transmits on its sending node's rank, so bytes add up
+    // and the peak and saturation time are the largest seen (-1 elsewhere).
+    void MergeRanks() {
+        std::vector<uint64_t> bytes(m_directions.size());
+        std::vector<double> peaks(m_directions.size());
+        std::vector<int64_t> saturated(m_directions.size());
+        for (size_t i = 0; i < m_directions.size(); ++i) {
+            bytes[i] = m_directions[i].totalBytes;
+            peaks[i] = m_directions[i].peak;
+            saturated[i] = m_directions[i].saturatedAtNs;
+        }
+        ReduceToRoot(bytes.data(), bytes.size());
+        ReduceToRoot(peaks.data(), peaks.size(), RankReduce::kMax);
+        ReduceToRoot(saturated.data(), saturated.size(), RankReduce::kMax);
+        for (size_t i = 0; i < m_directions.size(); ++i) {
+            m_directions[i].totalBytes = bytes[i];
+            m_directions[i].peak = peaks[i];
+            m_directions[i].saturatedAtNs = saturated[i];
+        }
+    }
+
+    double MeanUtilization(uint32_t direction) const {
+        const Direction& d = m_directions[direction];
+        double seconds = (m_endNs - m_startNs) / 1e9;
+        return d.bitRate > 0 && seconds > 0 ? d.totalBytes * 8.0 / (d.bitRate * seconds) : 0.0;
+    }
+
+    // Ranked table in text and as "link,rate_bps,mean_utilization,..." CSV
+    bool WriteReport(const std::string& textPath, const std::string& csvPath) const {
+        std::vector<uint32_t> order(m_directions.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [this](uint32_t x, uint32_t y) {
+            const Direction& a = m_directions[x];
+            const Direction& b = m_directions[y];
+            if (a.saturatedAtNs != b.saturatedAtNs) {
+                return b.saturatedAtNs < 0 || (a.saturatedAtNs >= 0 && a.saturatedAtNs < b.saturatedAtNs);
+            }
+            if (a.peak != b.peak) {
+                return a.peak > b.peak;
+            }
+            return MeanUtilization(x) > MeanUtilization(y);
+        });
+
+        std::ofstream text(textPath);
+        std::ofstream csv(csvPath);
+        if (!text.is_open() || !csv.is_open()) {
+            return false;
+        }
+        text << "Link Utilization (window " << m_binNs * kBins / 1e9 << "s, saturation at "
+             << m_threshold * 100 << "%), busiest first:\n";
+        text << std::setw(5) << "Rank" << std::setw(14) << "Link" << std::setw(12) << "Rate(Mbps)"
+             << std::setw(10) << "Mean" << std::setw(10) << "Peak" << std::setw(14) << "Saturated at" << "\n";
+        csv << std::setprecision(9) << "rank,link,rate_bps,mean_utilization,peak_utilization,saturated_at\n";
+        text << std::fixed;
+        for (uint32_t rank = 0; rank < order.size(); ++rank) {
+            const Direction& d = m_directions[order[rank]];
+            double mean = MeanUtilization(order[rank]);
+            text << std::setw(5) << rank + 1 << std::setw(14) << d.name << std::setw(12) << std::setprecision(2)
+                 << d.bitRate / 1e6 << std::setw(9) << std::setprecision(1) << mean * 100 << "%" << std::setw(9)
+                 << d.peak * 100 << "%" << std::setw(14);
+            if (d.saturatedAtNs >= 0) {
+                text << std::setprecision(3) << d.saturatedAtNs / 1e9;
+            } else {
+                text << "never";
+            }
+            text << "\n";
+            csv << rank + 1 << "," << d.name << "," << d.bitRate << "," << mean << "," << d.peak << ","
+                << (d.saturatedAtNs >= 0 ? std::to_string(d.saturatedAtNs / 1e9) : "") << "\n";
+        }
+        return text.good() && csv.good();
+    }
+
+private:
+    static const uint32_t kBins = 10;
+
+    struct Direction {
+        std::string name;
+        uint64_t bitRate = 0;
+        uint64_t totalBytes = 0;
+        int64_t bin = 0;                 // index of the sub-bin being filled
+        uint64_t bins[kBins] = {};       // bytes per sub-bin, ring indexed by bin % kBins
+        uint64_t windowBytes = 0;        // sum of the closed sub-bins in the ring
+        double peak = 0;
+        int64_t saturatedAtNs = -1;
+    };
+
+    static void TxEnd(LinkUtilizationMonitor* monitor, uint32_t direction, Ptr<const Packet> packet) {
+        ++TraceCallbackCount();
+        Direction& d = monitor->m_directions[direction];
+        monitor->Advance(d, Simulator::Now().GetNanoSeconds() / monitor->m_binNs);
+        d.bins[d.bin % kBins] += packet->GetSize();
+        d.totalBytes += packet->GetSize();
+    }
+
+    // Closes sub-bins up to (not including) 'bin', evaluating the window that
+    // ends with each one. Idle stretches longer than a window are skipped.
+    void Advance(Direction& d, int64_t bin) {
+        if (bin - d.bin > int64_t(kBins)) {
+            CloseBin(d);
+            std::fill(d.bins, d.bins + kBins, 0);
+            d.windowBytes = 0;
+            d.bin = bin;
+            return;
+        }
+        while (d.bin < bin) {
+            CloseBin(d);
+            ++d.bin;
+            d.windowBytes -= d.bins[d.bin % kBins];
+            d.bins[d.bin % kBins] = 0;
+        }
+    }
+
+    void CloseBin(Direction& d) {
+        d.windowBytes += d.bins[d.bin % kBins];
+        if (d.bitRate == 0) {
+            return;
+        }
+        double utilization = d.windowBytes * 8.0 / (d.bitRate * (m_binNs * kBins / 1e9));
+        d.peak = std::max(d.peak, utilization);
+        if (d.saturatedAtNs < 0 && utilization >= m_threshold) {
+            d.saturatedAtNs = (d.bin + 1) * m_binNs;
+        }
+    }
+
+    int64_t m_binNs;
+    double m_threshold;
+    int64_t m_startNs;
+    int64_t m_endNs;
+    std::vector<Direction> m_directions;
+};
+
+#endif // LINK_UTILIZATION_H
@@ -8,240 +8,216 @@
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/error-model.h" 
+#include "topology_builder.h"
+#include "topology_generator.h"
+#include "ip_node_map.h"
+#include "distributed.h"
+#include "forked_partitions.h"
+#include "experiment_options.h"
+#include "run_profiler.h"
+#include "incremental_router.h"
+#include "error_models.h"
+#include "traffic_generator.h"
+#include "link_utilization.h"
+#include "drop_accounting.h"
+#include "edge_flow_monitor.h"
+#include "traffic_matrix.h"
 #include <map>
 #include <utility>
 #include <string>
 #include <iostream>
 #include <random>
 #include <fstream>
-#include <iomanip>
-#include "ns3/flow-monitor-module.h"
+#include <thread>
 #include <iomanip>
 
 using namespace ns3;
 
 
-// Declare the traffic matrix
-std::map<std::pair<std::string, std::string>, uint32_t> trafficMatrix;
-std::map<Ipv4Address, std::string> ipToNodeName;
+// Declare the traffic matrix (lost packets, rows = source host, columns = destination host)
+TrafficMatrix trafficMatrix;
 NS_LOG_COMPONENT_DEFINE("CustomNetworkSimulation");
 
 
-// Function to print the packet drop rates in a matrix format
-void PrintPacketDropMatrix(std::map<std::pair<std::string, std::string>, uint32_t> trafficMatrix, 
-                           std::vector<std::string> hostNames) {
-    std::ofstream outFile("packet_srop.txt");  // Open file for writing
+// Function to print the packet drop rates in a matrix format, plus CSV and
+// binary copies for the sweep runner and offline tools
+void PrintPacketDropMatrix(const TrafficMatrix& trafficMatrix, const std::string& outputDir) {
+    std::ofstream outFile(outputDir + "/packet_drop.txt");  // Open file for writing
 
     if (!outFile.is_open()) {
         std::cerr << "Error opening file for writing!" << std::endl;
         return;
     }
+    trafficMatrix.WriteText(outFile, "Packet Drops:", "From:", 10, "");
+    outFile.close(); // Close the file after writing
 
-    // Print the header row
-    outFile << "Packet Drops:\n";
-    outFile << std::setw(10) << "From:";
-    for (const auto &to : hostNames) {
-        outFile << std::setw(10) << to;
-    }
-    outFile << std::endl;
-
-    // Print each row
-    for (const auto &from : hostNames) {
-        outFile << std::setw(10) << from;
-        for (const auto &to : hostNames) {
-            if (from == to) {
-                outFile << std::setw(10) << 0; // No self-drops
-            } else {
-                auto it = trafficMatrix.find(std::make_pair(from, to));
-                if (it != trafficMatrix.end()) {
-                    outFile << std::setw(10) << it->second;
-                } else {
-                    outFile << std::setw(10) << 0; // No data
-                }
-            }
-        }
-        outFile << std::endl;
+    if (!trafficMatrix.WriteCsv(outputDir + "/packet_drop.csv", "lost") ||
+        !trafficMatrix.WriteBinary(outputDir + "/packet_drop.bin")) {
+        std::cerr << "Error writing " << outputDir << "/packet_drop.csv or .bin!" << std::endl;
     }
-
-    outFile.close(); // Close the file after writing
 }
 
-// Custom Check for lost packets using FlowMonitor
-void CheckForLostPackets(Ptr<FlowMonitor> flowMonitor, 
-                         Ptr<Ipv4FlowClassifier> classifier,
-                         std::map<std::pair<std::string, std::string>, uint32_t> &trafficMatrix,
-                         std::map<Ipv4Address, std::string> &ipToNodeName) {
-    FlowMonitor::FlowStatsContainer stats = flowMonitor->GetFlowStats();
-    for (const auto &flow : stats) {
-        Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(flow.first);
-
-        // Get source and destination node names
-        std::string sourceNode = ipToNodeName[t.sourceAddress];
-        std::string destNode = ipToNodeName[t.destinationAddress];
-
-        // Debug: Print traffic information for this flow
-        std::cout << "Flow from " << sourceNode << " to " << destNode << ": "
-                  << "Lost Packets = " << flow.second.lostPackets << ", "
-                  << "Tx Packets = " << flow.second.txPackets << ", "
-                  << "Rx Packets = " << flow.second.rxPackets << std::endl;
-
-        // Update the traffic matrix
-        trafficMatrix[{sourceNode, destNode}] += flow.second.lostPackets;
+// Custom Check for lost packets using the edge flow monitor
+void CheckForLostPackets(const EdgeFlowMonitor &flowMonitor,
+                         TrafficMatrix &trafficMatrix,
+                         const IpNodeMap &ipToNode) {
+    for (const auto &flow : flowMonitor.GetFlows()) {
+        // Get source and destination nodes; host indexes are the matrix rows
+        uint32_t src = ipToNode.Find(flow.source);
+        uint32_t dst = ipToNode.Find(flow.destination);
+
+        // Lost is tx - rx. Across MPI ranks a flow is sent on one rank and
+        // received on another; the per-rank terms wrap around but their sum
+        // over the ranks is the loss. The per-flow losses are only meaningful
+        // once summed, so they are reported through the reduced matrix.
+        uint32_t lost = uint32_t(flow.txPackets - flow.rxPackets);
+
+        // Update the traffic matrix, skipping flows that do not run between hosts
+        if (src < trafficMatrix.GetN() && dst < trafficMatrix.GetN()) {
+            trafficMatrix.Increment(src, dst, lost);
+        }
     }
 }
 
 
 int main(int argc, char *argv[]) {
 
+    ExperimentOptions options;
+    double utilizationWindow = 1.0;
+    double saturationThreshold = 0.9;
+    bool distributed = false;
+    uint32_t isolate = 0;
+    uint32_t workers = std::thread::hardware_concurrency();
     CommandLine cmd;
-    cmd.Parse(argc, argv);
+    AddExperimentOptions(cmd, options);
+    cmd.AddValue("UtilizationWindow", "Sliding window for link utilization (seconds)", utilizationWindow);
+    cmd.AddValue("SaturationThreshold", "Windowed utilization at which a link counts as saturated", saturationThreshold);
+    cmd.AddValue("Distributed", "Run as MPI ranks, one router domain each (start with mpirun)", distributed);
+    cmd.AddValue("Isolate", "Run the sources in this many groups (source i in group i % Isolate), each "
+                 "alone in its own process, and sum their losses (0 or 1: all together)", isolate);
+    cmd.AddValue("Workers", "Source groups run at the same time with Isolate", workers);
+    ParseExperimentOptions(cmd, options, argc, argv);
+    if (distributed) {
+        EnableDistributed(argc, argv);
+    }
 
     Time::SetResolution(Time::NS);
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
     
 
     // Enable logging for debugging
-    LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
-    LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
-
-    // Create 7 hosts (A-G) and 4 routers (R1-R4)
-    NodeContainer hosts;
-    hosts.Create(7);
-    NodeContainer routers;
-    routers.Create(4);
-       std::vector<std::string> hostNames = {"A", "B", "C", "D", "E", "F", "G"};
-
-    InternetStackHelper stack;
-    Ipv4GlobalRoutingHelper globalRouting; // Ensure global routing is used
-stack.SetRoutingHelper(globalRouting);
-    stack.Install(hosts);
-    stack.Install(routers);
-
- PointToPointHelper p2p;
-
-    // Define link parameters based on the image topology
-    // Connect hosts to their respective routers
-    NetDeviceContainer hostDevices[7];
-    NetDeviceContainer routerDevices;
-    // Host-to-Router links with capacities from Table 3
-    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // A - R1
-    hostDevices[0] = p2p.Install(NodeContainer(hosts.Get(0), routers.Get(0)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // B - R1
-    hostDevices[1] = p2p.Install(NodeContainer(hosts.Get(1), routers.Get(0)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // C - R3
-    hostDevices[2] = p2p.Install(NodeContainer(hosts.Get(2), routers.Get(2)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("2Mbps")); // D - R3
-    hostDevices[3] = p2p.Install(NodeContainer(hosts.Get(3), routers.Get(2)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // E - R2
-    hostDevices[4] = p2p.Install(NodeContainer(hosts.Get(4), routers.Get(1)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // F - R2
-    hostDevices[5] = p2p.Install(NodeContainer(hosts.Get(5), routers.Get(1)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // G - R4
-    hostDevices[6] = p2p.Install(NodeContainer(hosts.Get(6), routers.Get(3)));
-
-    // Router-to-Router links with capacities from Table 3
-    p2p.SetDeviceAttribute("DataRate", StringValue("3Mbps")); // R1 - R2
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(0), routers.Get(1))));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("2.5Mbps")); // R1 - R3
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(0), routers.Get(2))));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1.5Mbps")); // R3 - R4
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(2), routers.Get(3))));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // R2 - R4
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(1), routers.Get(3))));
-
-    // Create an Error Model
-Ptr<RateErrorModel> errorModel = CreateObject<RateErrorModel>();
-errorModel->SetAttribute("ErrorRate", DoubleValue(0.01)); // 1% packet drop rate
-
-// Apply the error model to each device
-for (uint32_t i = 0; i < 7; ++i) {
-        hostDevices[i].Get(1)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); 
-    }
-    for (uint32_t i = 0; i < routerDevices.GetN(); ++i) {
-        routerDevices.Get(i)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); 
-    }
-
-    // Assign IP addresses to all links
-    Ipv4AddressHelper address;
-    std::string baseIp = "10.1.";
-    for (uint32_t i = 0; i < 7; ++i) {
-        address.SetBase(Ipv4Address((baseIp + std::to_string(i) + ".0").c_str()), "255.255.255.0");
-        address.Assign(hostDevices[i]);
+    if (options.logPackets) {
+        LogComponentEnable("PacketSink", LOG_LEVEL_INFO);
     }
 
-    for (uint32_t i = 0; i < routerDevices.GetN(); ++i) {
-        address.SetBase(Ipv4Address((baseIp + std::to_string(i + 7) + ".0").c_str()), "255.255.255.0");
-        address.Assign(routerDevices.Get(i));
+    // Build the 7-host / 4-router network (A-G, R1-R4) from the Table 3 link table
+    std::vector<std::string> hostNames = DefaultHostNames();
+    std::vector<std::string> routerNames = DefaultRouterNames();
+    std::vector<LinkSpec> links = DefaultLinkTable();
+    if (!options.linkTable.empty()) {
+        LoadLinkTable(options.linkTable, hostNames, routerNames, links);
     }
-
-    // Set up UDP Echo server on Host A (host 0)
-    UdpEchoServerHelper echoServer(9);
-    ApplicationContainer serverApps;
-    for (uint32_t i = 0; i < 7; ++i) {
-        ApplicationContainer serverApp = echoServer.Install(hosts.Get(i));
-        serverApps.Add(serverApp);
+    if (!options.topology.empty()) {
+        GenerateTopology(options.topology, hostNames, routerNames, links);
     }
-    serverApps.Start(Seconds(1.0));
-    serverApps.Stop(Seconds(10.0));
-
-    // Enable global routing
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
-
-    // Set up UDP Echo clients on remaining hosts (B-G)
-    for (uint32_t i = 0; i < 7; ++i) {
-        for (uint32_t j = 0; j < 7; ++j) {
-            if (i != j) { // Avoid sending traffic to itself
-                
-                UdpEchoClientHelper echoClient(Ipv4Address(("10.1." + std::to_string(j) + ".1").c_str()), 9);
-
-                // UdpEchoClientHelper echoClient(Ipv4Address("10.1.0.1"), 9);
-                echoClient.SetAttribute("MaxPackets", UintegerValue(1000));
-                echoClient.SetAttribute("Interval", TimeValue(Seconds(0.01)));
-                echoClient.SetAttribute("PacketSize", UintegerValue(1024));
-
-                ApplicationContainer clientApps = echoClient.Install(hosts.Get(i));
-                clientApps.Start(Seconds(2.0 + i + j));
-                clientApps.Stop(Seconds(10.0));
-            }
+    InternetStackHelper stack;
+    Topology topo = BuildTopology(hostNames, routerNames, links, stack, ExperimentAddressPlan(options),
+                                  PartitionByRouterDomain(hostNames, routerNames, links, MpiSize()));
+    NodeContainer hosts = topo.hosts;
+
+    // An independent error model per link, from the link table's loss column
+    // (ErrorRate on links without one), each on its own RNG streams
+    InstallErrorModels(topo, options.errorRate);
+
+    // Global routing, or the incremental router when links fail during the run
+    std::unique_ptr<IncrementalRouter> router = SetUpRouting(topo, options.linkEvents);
+
+    // Where and why packets are lost, next to the per-flow totals
+    DropAccounting dropAccounting(topo);
+
+    // IP to node mapping, from every interface address the stack holds
+    IpNodeMap ipToNode(topo);
+
+    // Every host sends to every other host (to the next Peers hosts with
+    // --Peers): Poisson arrivals averaging one packet per Interval per pair,
+    // for as long as MaxPackets packets take on average
+    TrafficMatrix traffic = PeerTrafficMatrix(hostNames, options.peers, 1);
+    Time trafficStop = Seconds(std::min(options.appStopTime, 2.0 + options.maxPackets * options.interval));
+    trafficMatrix = TrafficMatrix(hostNames);
+
+    // With Isolate, each group of sources runs alone in a forked copy of this
+    // process, on the network built above; their losses and drop causes are
+    // summed (each child starts from the empty counters above)
+    if (isolate > 1) {
+        NS_ABORT_MSG_IF(distributed, "Isolate and Distributed cannot be combined");
+        bool ok = RunForkedPartitions(
+            isolate, workers,
+            [&](uint32_t group, std::ostream& out) {
+                InstallMatrixTraffic(topo, SourceGroup(traffic, group, isolate), 1.0 / options.interval,
+                                     options.packetSize, 9, Seconds(2.0), trafficStop, 0);
+                EdgeFlowMonitor flowMonitor(topo);
+                Simulator::Stop(Seconds(options.stopTime));
+                Simulator::Run();
+                CheckForLostPackets(flowMonitor, trafficMatrix, ipToNode);
+                trafficMatrix.WriteRaw(out);
+                dropAccounting.Save(out);
+                Simulator::Destroy();
+            },
+            [&](uint32_t group, std::istream& in) {
+                if (!trafficMatrix.AddRaw(in) || !dropAccounting.MergeFrom(in)) {
+                    std::cerr << "Error: truncated results from source group " << group << std::endl;
+                }
+            });
+        PrintPacketDropMatrix(trafficMatrix, options.outputDir);
+        if (!dropAccounting.Write(options.outputDir + "/drop_causes.txt", options.outputDir + "/drop_causes.csv")) {
+            std::cerr << "Error writing the drop cause matrix!" << std::endl;
         }
+        Simulator::Destroy();
+        return ok ? 0 : 1;
     }
-    // Set up FlowMonitor
-    Ptr<FlowMonitor> flowMonitor;
-    FlowMonitorHelper flowHelper;
-    flowMonitor = flowHelper.InstallAll();
-
-    // IP to Node Name Mapping
-    ipToNodeName[Ipv4Address("10.1.0.1")] = "A";
-    ipToNodeName[Ipv4Address("10.1.1.1")] = "B";
-    ipToNodeName[Ipv4Address("10.1.2.1")] = "C";
-    ipToNodeName[Ipv4Address("10.1.3.1")] = "D";
-    ipToNodeName[Ipv4Address("10.1.4.1")] = "E";
-    ipToNodeName[Ipv4Address("10.1.5.1")] = "F";
-    ipToNodeName[Ipv4Address("10.1.6.1")] = "G";
+
+    InstallMatrixTraffic(topo, traffic, 1.0 / options.interval, options.packetSize, 9, Seconds(2.0), trafficStop, 0);
+
+    // Per-direction link utilization, counted as packets leave each device
+    LinkUtilizationMonitor utilization(topo, Seconds(utilizationWindow), saturationThreshold);
+
+    // Per-flow tx/rx counters, kept on the hosts only
+    EdgeFlowMonitor flowMonitor(topo);
 
     // Run the simulation
-    Simulator::Stop(Seconds(60.0));
+    Simulator::Stop(Seconds(options.stopTime));
+    RunProfiler profiler(topo, options.profile);
     Simulator::Run();
+    profiler.Finish(std::cout);
+    utilization.Finish(Simulator::Now());
 
     // Analyze the packet loss
-    Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flowHelper.GetClassifier());
-    CheckForLostPackets(flowMonitor, classifier, trafficMatrix, ipToNodeName);
+    CheckForLostPackets(flowMonitor, trafficMatrix, ipToNode);
+
+    // In a distributed run rank 0 collects everything and writes the results
+    utilization.MergeRanks();
+    dropAccounting.MergeRanks();
+    ReduceToRoot(trafficMatrix.Data(), size_t(trafficMatrix.GetN()) * trafficMatrix.GetN());
+    if (MpiRank() != 0) {
+        Simulator::Destroy();
+        DisableDistributed();
+        return 0;
+    }
+    if (router && !router->WriteLinkChanges(options.outputDir + "/link_changes.txt")) {
+        std::cerr << "Error writing link_changes.txt!" << std::endl;
+    }
+    if (!utilization.WriteReport(options.outputDir + "/link_utilization.txt",
+                                 options.outputDir + "/link_utilization.csv")) {
+        std::cerr << "Error writing the link utilization report!" << std::endl;
+    }
 
     // Print the packet drop matrix
-    PrintPacketDropMatrix(trafficMatrix, hostNames);
+    PrintPacketDropMatrix(trafficMatrix, options.outputDir);
+    if (!dropAccounting.Write(options.outputDir + "/drop_causes.txt", options.outputDir + "/drop_causes.csv")) {
+        std::cerr << "Error writing the drop cause matrix!" << std::endl;
+    }
 
     // Clean up and exit
     Simulator::Destroy();
+    DisableDistributed();
     return 0;
 }
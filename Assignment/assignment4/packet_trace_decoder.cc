@@ -0,0 +1,80 @@
+// Offline decoder for the binary traces written by tracking_path.cc and
+// packet_trace_updated_names.cc. Prints the same lines the old std::endl
+// trace produced, e.g.
+//
+//   ./packet_trace_decoder packet-traces.bin > packet_traces.txt
+//   ./packet_trace_decoder packet-traces.bin packet-traces.aliases > packet_traces_updated_name.txt
+//
+// With an alias file the node, source and destination fields are alias ids
+// (see NodeAliasTable) and the file has one "alias <id> <name>" entry per
+// line; ids it does not cover are printed as "Unknown".
+#include "packet_trace_writer.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::string FormatIpv4(uint32_t address) {
+    std::ostringstream os;
+    os << ((address >> 24) & 0xff) << "." << ((address >> 16) & 0xff) << "."
+       << ((address >> 8) & 0xff) << "." << (address & 0xff);
+    return os.str();
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " <trace.bin> [aliases]" << std::endl;
+        return 1;
+    }
+
+    PacketTraceReader reader;
+    std::string error = reader.Open(argv[1]);
+    if (!error.empty()) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+
+    bool useAliases = argc == 3;
+    std::vector<std::string> aliasNames;
+    if (useAliases) {
+        std::ifstream aliasFile(argv[2]);
+        if (!aliasFile.is_open()) {
+            std::cerr << "Error: cannot open " << argv[2] << std::endl;
+            return 1;
+        }
+        std::string kind, name;
+        uint32_t id;
+        while (aliasFile >> kind >> id >> name) {
+            if (kind != "alias") {
+                std::cerr << "Error: bad alias entry '" << kind << " " << id << "'" << std::endl;
+                return 1;
+            }
+            if (id >= aliasNames.size()) {
+                aliasNames.resize(id + 1, "Unknown");
+            }
+            aliasNames[id] = name;
+        }
+    }
+    auto lookup = [&aliasNames](uint32_t id) {
+        return id < aliasNames.size() ? aliasNames[id] : std::string("Unknown");
+    };
+
+    std::ios::sync_with_stdio(false);
+    PacketTraceRecord record;
+    while (reader.Next(record)) {
+        std::cout << record.timeNs / 1e9 << " Packet " << record.uid << " at Node ";
+        if (useAliases) {
+            std::cout << lookup(record.node)
+                      << " on Interface " << record.iface
+                      << " Source: " << lookup(record.src)
+                      << " Destination: " << lookup(record.dst);
+        } else {
+            std::cout << record.node
+                      << " on Interface " << record.iface
+                      << " Source: " << FormatIpv4(record.src)
+                      << " Destination: " << FormatIpv4(record.dst);
+        }
+        std::cout << '\n';
+    }
+    return 0;
+}
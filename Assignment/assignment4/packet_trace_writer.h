@@ -0,0 +1,145 @@
+#ifndef PACKET_TRACE_WRITER_H
+#define PACKET_TRACE_WRITER_H
+
+// Fixed-width binary packet trace. Plain C++ on purpose so the offline
+// decoder (packet_trace_decoder.cc) can use it without ns-3.
+//
+// File layout: a 16-byte header followed by 32-byte records, all in host
+// byte order (the header's byte-order mark lets the reader reject a file
+// written on a machine with the other endianness).
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct PacketTraceHeader {
+    char magic[8];      // "PKTTRACE"
+    uint32_t byteOrder; // kPacketTraceByteOrder as written by the producer
+    uint32_t version;
+};
+
+struct PacketTraceRecord {
+    int64_t timeNs;
+    uint64_t uid;
+    uint32_t node;
+    uint32_t iface;
+    uint32_t src;       // IPv4 address as returned by Ipv4Address::Get()
+    uint32_t dst;
+};
+
+static_assert(sizeof(PacketTraceHeader) == 16, "trace header must stay 16 bytes");
+static_assert(sizeof(PacketTraceRecord) == 32, "trace record must stay 32 bytes");
+
+const char kPacketTraceMagic[8] = {'P', 'K', 'T', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t kPacketTraceByteOrder = 0x01020304;
+const uint32_t kPacketTraceVersion = 1;
+
+// Collects records in a fixed buffer and writes it out in one call when it
+// fills up, so the per-packet cost is a struct copy rather than a formatted,
+// flushed line.
+class PacketTraceWriter {
+public:
+    explicit PacketTraceWriter(size_t bufferRecords = 4096) : m_capacity(bufferRecords) {
+        m_buffer.reserve(m_capacity);
+    }
+
+    ~PacketTraceWriter() { Close(); }
+
+    bool Open(const std::string& path) {
+        m_file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!m_file.is_open()) {
+            return false;
+        }
+        PacketTraceHeader header;
+        std::memcpy(header.magic, kPacketTraceMagic, sizeof(header.magic));
+        header.byteOrder = kPacketTraceByteOrder;
+        header.version = kPacketTraceVersion;
+        m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return m_file.good();
+    }
+
+    bool IsOpen() const { return m_file.is_open(); }
+
+    void Write(const PacketTraceRecord& record) {
+        m_buffer.push_back(record);
+        if (m_buffer.size() == m_capacity) {
+            Flush();
+        }
+    }
+
+    void Flush() {
+        if (!m_buffer.empty() && m_file.is_open()) {
+            m_file.write(reinterpret_cast<const char*>(m_buffer.data()),
+                         m_buffer.size() * sizeof(PacketTraceRecord));
+            m_written += m_buffer.size();
+        }
+        m_buffer.clear();
+    }
+
+    void Close() {
+        if (m_file.is_open()) {
+            Flush();
+            m_file.close();
+        }
+    }
+
+    uint64_t RecordsWritten() const { return m_written + m_buffer.size(); }
+
+private:
+    size_t m_capacity;
+    std::vector<PacketTraceRecord> m_buffer;
+    std::ofstream m_file;
+    uint64_t m_written = 0;
+};
+
+// Reads a trace back in chunks; Next() returns false at end of file.
+class PacketTraceReader {
+public:
+    explicit PacketTraceReader(size_t bufferRecords = 4096) : m_buffer(bufferRecords) {}
+
+    // Returns an empty string on success, otherwise what went wrong.
+    std::string Open(const std::string& path) {
+        m_file.open(path, std::ios::in | std::ios::binary);
+        if (!m_file.is_open()) {
+            return "cannot open " + path;
+        }
+        PacketTraceHeader header;
+        if (!m_file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            return path + " is too short to be a packet trace";
+        }
+        if (std::memcmp(header.magic, kPacketTraceMagic, sizeof(header.magic)) != 0) {
+            return path + " is not a packet trace";
+        }
+        if (header.byteOrder != kPacketTraceByteOrder) {
+            return path + " was written with a different byte order";
+        }
+        if (header.version != kPacketTraceVersion) {
+            return path + " has unsupported trace version " + std::to_string(header.version);
+        }
+        return "";
+    }
+
+    bool Next(PacketTraceRecord& record) {
+        if (m_pos == m_count) {
+            m_file.read(reinterpret_cast<char*>(m_buffer.data()),
+                        m_buffer.size() * sizeof(PacketTraceRecord));
+            m_count = static_cast<size_t>(m_file.gcount()) / sizeof(PacketTraceRecord);
+            m_pos = 0;
+            if (m_count == 0) {
+                return false;
+            }
+        }
+        record = m_buffer[m_pos++];
+        return true;
+    }
+
+private:
+    std::ifstream m_file;
+    std::vector<PacketTraceRecord> m_buffer;
+    size_t m_count = 0;
+    size_t m_pos = 0;
+};
+
+#endif // PACKET_TRACE_WRITER_H
@@ -0,0 +1,230 @@
+#ifndef PATH_TRACKER_H
+#define PATH_TRACKER_H
+
+// Reconstructs every packet's hop-by-hop path during the run. A path opens
+// when a node's IP layer sends a packet (SendOutgoing), gains a hop at every
+// IP receive (Rx) and closes when the packet is delivered locally
+// (LocalDeliver); the closed path is folded into per-flow statistics and its
+// hop vector goes back to a pool. An echo reply keeps the request's uid but
+// is sent afresh, so it is tracked as its own path.
+//
+// Per flow (source host, destination host) the tracker keeps how often each
+// distinct path was taken, its end-to-end delay and the delay of each hop
+// along it. Paths that never close (lost packets) are reported by the node
+// they were last seen at. Node and flow ids are NodeAliasTable aliases.
+// Distinct paths are interned once, by a hash of their node sequence, and
+// flows refer to them by id.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "run_profiler.h"
+#include "running_stats.h"
+#include "topology_builder.h"
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+class PathTracker {
+public:
+    explicit PathTracker(const Topology& topo) : m_aliases(topo.aliases) {
+        for (uint32_t i = 0; i < topo.nodes.GetN(); ++i) {
+            Ptr<Ipv4L3Protocol> ipv4 = topo.nodes.Get(i)->GetObject<Ipv4L3Protocol>();
+            if (!ipv4) {
+                continue;
+            }
+            ipv4->TraceConnectWithoutContext("SendOutgoing", MakeBoundCallback(&PathTracker::Send, this, i));
+            ipv4->TraceConnectWithoutContext("Rx", MakeBoundCallback(&PathTracker::Receive, this, i));
+            ipv4->TraceConnectWithoutContext("LocalDeliver", MakeBoundCallback(&PathTracker::Deliver, this, i));
+        }
+    }
+
+    // Per flow, each path with its share, end-to-end and per-hop mean delay,
+    // then where the unfinished packets were last seen
+    bool WriteReport(const std::string& textPath, const std::string& csvPath) const {
+        std::ofstream text(textPath);
+        std::ofstream csv(csvPath);
+        if (!text.is_open() || !csv.is_open()) {
+            return false;
+        }
+        text << std::fixed;
+        csv << std::setprecision(9) << "src,dst,path,packets,mean_delay,hop_delays\n";
+        for (const auto& flow : m_flows) {
+            const std::string& src = m_aliases.Name(flow.first.first);
+            const std::string& dst = m_aliases.Name(flow.first.second);
+            uint64_t delivered = 0;
+            for (const auto& path : flow.second.paths) {
+                delivered += path.second.endToEnd.count;
+            }
+            text << src << " -> " << dst << ": " << delivered << " delivered";
+            uint64_t lost = 0;
+            for (const auto& last : flow.second.lostAt) {
+                lost += last.second;
+            }
+            if (lost) {
+                text << ", " << lost << " unfinished";
+            }
+            text << "\n";
+            for (const auto& path : flow.second.paths) {
+                const PathStats& stats = path.second;
+                const std::vector<uint32_t>& nodes = m_paths[path.first];
+                std::string name = PathName(nodes);
+                text << "  " << std::setw(24) << std::left << name << std::right << std::setw(8)
+                     << stats.endToEnd.count << std::setprecision(1) << std::setw(7)
+                     << 100.0 * stats.endToEnd.count / delivered << "%  mean " << std::setprecision(6)
+                     << stats.endToEnd.mean << "s  hops:";
+                std::string hopDelays;
+                for (size_t h = 0; h < stats.hops.size(); ++h) {
+                    text << " " << m_aliases.Name(nodes[h]) << "->" << m_aliases.Name(nodes[h + 1])
+                         << " " << stats.hops[h].mean << "s";
+                    hopDelays += (h ? ";" : "") + std::to_string(stats.hops[h].mean);
+                }
+                text << "\n";
+                csv << src << "," << dst << "," << name << "," << stats.endToEnd.count << ","
+                    << stats.endToEnd.mean << "," << hopDelays << "\n";
+            }
+            for (const auto& last : flow.second.lostAt) {
+                text << "  unfinished at " << m_aliases.Name(last.first) << ": " << last.second << "\n";
+            }
+        }
+        return text.good() && csv.good();
+    }
+
+    // Counts the paths still open (packets lost or in flight) by the node they
+    // were last seen at; call once after Simulator::Run()
+    void Finish() {
+        for (const auto& open : m_open) {
+            const OpenPath& path = m_pool[open.second];
+            m_flows[{path.src, path.dst}].lostAt[path.hops.back().node]++;
+        }
+        m_open.clear();
+    }
+
+private:
+    struct Hop {
+        uint32_t node;
+        int64_t timeNs;
+    };
+
+    struct OpenPath {
+        uint32_t src;
+        uint32_t dst;
+        std::vector<Hop> hops;
+    };
+
+    struct PathStats {
+        RunningStats endToEnd;
+        std::vector<RunningStats> hops;   // hops[h]: node h to node h + 1
+    };
+
+    struct FlowStats {
+        std::map<uint32_t, PathStats> paths;   // by path id, in order of first use
+        std::map<uint32_t, uint64_t> lostAt;
+    };
+
+    static void Send(PathTracker* tracker, uint32_t node, const Ipv4Header& header, Ptr<const Packet> packet,
+                     uint32_t) {
+        ++TraceCallbackCount();
+        uint64_t uid = packet->GetUid();
+        auto it = tracker->m_open.find(uid);
+        if (it != tracker->m_open.end()) {
+            tracker->Release(it->second);   // superseded, e.g. never delivered
+            tracker->m_open.erase(it);
+        }
+        uint32_t slot = tracker->Acquire();
+        OpenPath& path = tracker->m_pool[slot];
+        path.src = tracker->m_aliases.ForAddress(header.GetSource());
+        path.dst = tracker->m_aliases.ForAddress(header.GetDestination());
+        path.hops.push_back({node, Simulator::Now().GetNanoSeconds()});
+        tracker->m_open.emplace(uid, slot);
+    }
+
+    static void Receive(PathTracker* tracker, uint32_t node, Ptr<const Packet> packet, Ptr<Ipv4>, uint32_t) {
+        ++TraceCallbackCount();
+        auto it = tracker->m_open.find(packet->GetUid());
+        if (it != tracker->m_open.end()) {
+            tracker->m_pool[it->second].hops.push_back({node, Simulator::Now().GetNanoSeconds()});
+        }
+    }
+
+    static void Deliver(PathTracker* tracker, uint32_t, const Ipv4Header&, Ptr<const Packet> packet, uint32_t) {
+        ++TraceCallbackCount();
+        auto it = tracker->m_open.find(packet->GetUid());
+        if (it == tracker->m_open.end()) {
+            return;
+        }
+        const OpenPath& path = tracker->m_pool[it->second];
+        tracker->m_scratch.resize(path.hops.size());
+        for (size_t h = 0; h < path.hops.size(); ++h) {
+            tracker->m_scratch[h] = path.hops[h].node;
+        }
+        PathStats& stats = tracker->m_flows[{path.src, path.dst}].paths[tracker->Intern(tracker->m_scratch)];
+        if (stats.hops.empty() && path.hops.size() > 1) {
+            stats.hops.resize(path.hops.size() - 1);
+        }
+        stats.endToEnd.Add((path.hops.back().timeNs - path.hops.front().timeNs) / 1e9);
+        for (size_t h = 0; h + 1 < path.hops.size(); ++h) {
+            stats.hops[h].Add((path.hops[h + 1].timeNs - path.hops[h].timeNs) / 1e9);
+        }
+        tracker->Release(it->second);
+        tracker->m_open.erase(it);
+    }
+
+    // Hop vectors are recycled with their capacity, so steady-state tracking
+    // does not allocate
+    uint32_t Acquire() {
+        if (m_free.empty()) {
+            m_pool.emplace_back();
+            return m_pool.size() - 1;
+        }
+        uint32_t slot = m_free.back();
+        m_free.pop_back();
+        return slot;
+    }
+
+    void Release(uint32_t slot) {
+        m_pool[slot].hops.clear();
+        m_free.push_back(slot);
+    }
+
+    // Id of the path 'nodes', added on first sight; only a new path allocates
+    uint32_t Intern(const std::vector<uint32_t>& nodes) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (uint32_t node : nodes) {
+            hash = (hash ^ node) * 0x100000001b3ULL;
+        }
+        auto range = m_pathIds.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (m_paths[it->second] == nodes) {
+                return it->second;
+            }
+        }
+        m_paths.push_back(nodes);
+        m_pathIds.emplace(hash, m_paths.size() - 1);
+        return m_paths.size() - 1;
+    }
+
+    std::string PathName(const std::vector<uint32_t>& nodes) const {
+        std::string name;
+        for (uint32_t node : nodes) {
+            name += (name.empty() ? "" : " ") + m_aliases.Name(node);
+        }
+        return name;
+    }
+
+    const NodeAliasTable& m_aliases;
+    std::unordered_map<uint64_t, uint32_t> m_open;   // packet uid -> pool slot
+    std::vector<OpenPath> m_pool;
+    std::vector<uint32_t> m_free;
+    std::vector<uint32_t> m_scratch;                        // node ids of the path being delivered
+    std::vector<std::vector<uint32_t>> m_paths;             // path id -> node ids
+    std::unordered_multimap<uint64_t, uint32_t> m_pathIds;  // hash of the node ids -> path id
+    std::map<std::pair<uint32_t, uint32_t>, FlowStats> m_flows;
+};
+
+#endif // PATH_TRACKER_H
@@ -0,0 +1,129 @@
+#ifndef PROCESS_POOL_H
+#define PROCESS_POOL_H
+
+// Runs shell commands as independent processes, one per worker thread, with a
+// work-stealing queue: jobs are dealt round-robin to per-worker deques, a
+// worker takes from the front of its own deque and, once that is empty,
+// steals from the back of the others. Plain C++/POSIX, no ns-3.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <vector>
+
+struct ProcessJob {
+    uint32_t id;
+    std::string command;
+};
+
+struct ProcessResult {
+    uint32_t id;
+    int exitCode;   // -1 if the command could not be run or was killed
+    double wallSeconds;
+};
+
+class ProcessPool {
+public:
+    explicit ProcessPool(uint32_t workers) : m_queues(workers ? workers : 1) {}
+
+    // Queues a command and returns its job id (0, 1, 2, ... in call order)
+    uint32_t Add(const std::string& command) {
+        uint32_t id = m_next++;
+        m_queues[id % m_queues.size()].jobs.push_back({id, command});
+        return id;
+    }
+
+    // Runs every job and returns the results in job order. 'onDone' is called
+    // (serialized) as each job finishes, e.g. for progress output.
+    std::vector<ProcessResult> Run(std::function<void(const ProcessResult&)> onDone = nullptr) {
+        std::vector<ProcessResult> results;
+        std::mutex resultsMutex;
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < m_queues.size(); ++w) {
+            threads.emplace_back([this, w, &results, &resultsMutex, &onDone]() {
+                ProcessJob job;
+                while (Take(w, job)) {
+                    ProcessResult result = Execute(job);
+                    std::lock_guard<std::mutex> lock(resultsMutex);
+                    results.push_back(result);
+                    if (onDone) {
+                        onDone(result);
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        std::vector<ProcessResult> ordered(results.size());
+        for (const auto& result : results) {
+            ordered[result.id] = result;
+        }
+        return ordered;
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<ProcessJob> jobs;
+    };
+
+    bool Take(size_t self, ProcessJob& job) {
+        {
+            std::lock_guard<std::mutex> lock(m_queues[self].mutex);
+            if (!m_queues[self].jobs.empty()) {
+                job = m_queues[self].jobs.front();
+                m_queues[self].jobs.pop_front();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < m_queues.size(); ++i) {
+            WorkQueue& victim = m_queues[(self + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                job = victim.jobs.back();
+                victim.jobs.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static ProcessResult Execute(const ProcessJob& job) {
+        auto start = std::chrono::steady_clock::now();
+        int status = std::system(job.command.c_str());
+        auto end = std::chrono::steady_clock::now();
+        ProcessResult result;
+        result.id = job.id;
+        result.exitCode = (status != -1 && WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+        result.wallSeconds = std::chrono::duration<double>(end - start).count();
+        return result;
+    }
+
+    std::vector<WorkQueue> m_queues;
+    uint32_t m_next = 0;
+};
+
+// 'text' as one shell word: single-quoted, with any ' inside closed, escaped
+// and reopened. Commands that wrap it in double quotes of their own (the ns3
+// wrapper templates) still expand $, `, " and \ in it; see
+// SafeInDoubleQuotes.
+inline std::string ShellQuote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+    return quoted + "'";
+}
+
+inline bool SafeInDoubleQuotes(const std::string& text) {
+    return text.find_first_of("$`\"\\") == std::string::npos;
+}
+
+#endif // PROCESS_POOL_H
@@ -5,115 +5,123 @@
 #include "ns3/applications-module.h"
 #include "ns3/flow-monitor-module.h"
 #include "ns3/queue.h"
+#include "topology_builder.h"
+#include "topology_generator.h"
+#include "experiment_options.h"
+#include "run_profiler.h"
+#include "incremental_router.h"
+#include "error_models.h"
+#include "async_trace_sink.h"
+#include "queue_monitor.h"
 #include <fstream>
 
 using namespace ns3;
 std::ofstream logFile;
-// Function to log queue lengths
-void LogQueueLength(Ptr<Queue<Packet>> queue, std::string linkDescription) {
-    uint32_t queueLength = queue->GetNPackets();
-    logFile << Simulator::Now().GetSeconds() << "s: " << linkDescription
-              << " Queue Length: " << queueLength << " packets" << std::endl;
+
+// Written by the sink's thread
+AsyncTraceSink<QueueSample> logSink;
+QueueMonitor* queueMonitor = nullptr;
+
+void WriteQueueSamples(const QueueSample* samples, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        logFile << samples[i].timeNs / 1e9 << "s: " << queueMonitor->Name(samples[i].queue)
+                << " Queue Length: " << samples[i].packets << " packets (max " << samples[i].maxPackets << ")\n";
+    }
 }
 
 int main(int argc, char *argv[]) {
+    ExperimentOptions options;
+    options.errorRate = 0.0;
+    options.maxPackets = 2000;
+    options.packetSize = 2048;
+    options.stopTime = 20.0;
+    double sampleInterval = 0.1;
+    bool echoPairs = false;
     CommandLine cmd;
-    cmd.Parse(argc, argv);
+    AddExperimentOptions(cmd, options);
+    cmd.AddValue("SampleInterval", "Queue length sampling interval in seconds (0 logs every change)", sampleInterval);
+    cmd.AddValue("EchoPairs", "Every host echoes with the host half way round the host list instead of all "
+                 "with host A", echoPairs);
+    ParseExperimentOptions(cmd, options, argc, argv);
 
-    logFile.open("queue_lengths.txt", std::ios::out);
+    logFile.open(options.outputDir + "/queue_lengths.txt", std::ios::out);
     if (!logFile.is_open()) {
         std::cerr << "Error: Could not open log file!" << std::endl;
         return 1;
     }
 
-    // Set up nodes
-    NodeContainer hosts;
-    hosts.Create(7); // Nodes A-G
-    NodeContainer routers;
-    routers.Create(4); // Routers R1-R4
-
-    InternetStackHelper stack;
-    stack.Install(hosts);
-    stack.Install(routers);
-
-    // Host-to-router links with different data rates
-    std::string hostToRouterRates[7] = {"1Mbps", "2Mbps", "1.5Mbps", "3Mbps", "1Mbps", "2Mbps", "2.5Mbps"};
-    NetDeviceContainer hostDevices[7];
-    for (uint32_t i = 0; i < 7; ++i) {
-        PointToPointHelper p2p;
-        p2p.SetChannelAttribute("Delay", StringValue("2ms"));
-        p2p.SetDeviceAttribute("DataRate", StringValue(hostToRouterRates[i]));
-
-        hostDevices[i] = p2p.Install(NodeContainer(hosts.Get(i), routers.Get(i % 4)));
-
-        std::string hostToRouterLink =  "R" + std::to_string((i % 4) + 1) + " -> "  + " Host " + std::string(1, 'A' + i) ;
-        Ptr<NetDevice> device = hostDevices[i].Get(0); // Outgoing device at host
-        Ptr<PointToPointNetDevice> p2pDevice = DynamicCast<PointToPointNetDevice>(device);
-        if (p2pDevice) {
-            Ptr<Queue<Packet>> queue = p2pDevice->GetQueue();
-            Simulator::Schedule(Seconds(1.0), &LogQueueLength, queue, hostToRouterLink);
-            Simulator::Schedule(Seconds(2.0), &LogQueueLength, queue, hostToRouterLink);
-        }
+    // Host i hangs off router i % 4; this experiment uses its own link rates
+    std::vector<std::string> hostNames = DefaultHostNames();
+    std::vector<std::string> routerNames = DefaultRouterNames();
+    std::vector<std::string> hostToRouterRates = {"1Mbps", "2Mbps", "1.5Mbps", "3Mbps", "1Mbps", "2Mbps", "2.5Mbps"};
+    std::vector<LinkSpec> links;
+    for (uint32_t i = 0; i < hostNames.size(); ++i) {
+        links.push_back({hostNames[i], routerNames[i % routerNames.size()],
+                         hostToRouterRates[i % hostToRouterRates.size()], "2ms"});
+    }
+    links.push_back({"R1", "R2", "4Mbps", "2ms"});
+    links.push_back({"R1", "R3", "5Mbps", "2ms"});
+    links.push_back({"R3", "R4", "3.5Mbps", "2ms"});
+    links.push_back({"R2", "R4", "4.5Mbps", "2ms"});
+    if (!options.linkTable.empty()) {
+        LoadLinkTable(options.linkTable, hostNames, routerNames, links);
+    }
+    if (!options.topology.empty()) {
+        GenerateTopology(options.topology, hostNames, routerNames, links);
     }
 
-    // Router-to-router links with different data rates
-    std::string routerToRouterRates[4] = {"4Mbps", "5Mbps", "3.5Mbps", "4.5Mbps"};
-    NetDeviceContainer routerDevices[4];
-    for (uint32_t i = 0; i < 4; ++i) {
-        PointToPointHelper p2p;
-        p2p.SetChannelAttribute("Delay", StringValue("2ms"));
-        p2p.SetDeviceAttribute("DataRate", StringValue(routerToRouterRates[i]));
-
-        if (i == 0) routerDevices[i] = p2p.Install(NodeContainer(routers.Get(0), routers.Get(1))); // R1 -> R2
-        else if (i == 1) routerDevices[i] = p2p.Install(NodeContainer(routers.Get(0), routers.Get(2))); // R1 -> R3
-        else if (i == 2) routerDevices[i] = p2p.Install(NodeContainer(routers.Get(2), routers.Get(3))); // R3 -> R4
-        else if (i == 3) routerDevices[i] = p2p.Install(NodeContainer(routers.Get(1), routers.Get(3))); // R2 -> R4
-
-        std::string linkDescription;
-        if (i == 0) linkDescription = "R1 -> R2";
-        else if (i == 1) linkDescription = "R1 -> R3";
-        else if (i == 2) linkDescription = "R3 -> R4";
-        else if (i == 3) linkDescription = "R2 -> R4";
+    InternetStackHelper stack;
+    Topology topo = BuildTopology(hostNames, routerNames, links, stack, ExperimentAddressPlan(options));
+    NodeContainer hosts = topo.hosts;
 
-        Ptr<NetDevice> device = routerDevices[i].Get(0); // Outgoing device at router
-        Ptr<PointToPointNetDevice> p2pDevice = DynamicCast<PointToPointNetDevice>(device);
-        if (p2pDevice) {
-            Ptr<Queue<Packet>> queue = p2pDevice->GetQueue();
-            Simulator::Schedule(Seconds(1.0), &LogQueueLength, queue, linkDescription);
-            Simulator::Schedule(Seconds(2.0), &LogQueueLength, queue, linkDescription);
-            Simulator::Schedule(Seconds(3.0), &LogQueueLength, queue, linkDescription);
-        }
-    }
+    // An independent error model per link, from the link table's loss column
+    // (ErrorRate on links without one), each on its own RNG streams
+    InstallErrorModels(topo, options.errorRate);
 
-    // Install Internet stack
-    Ipv4AddressHelper address;
-    address.SetBase("10.1.0.0", "255.255.255.0");
-    for (uint32_t i = 0; i < 7; ++i) {
-        address.Assign(hostDevices[i]);
-    }
-    for (uint32_t i = 0; i < 4; ++i) {
-        address.Assign(routerDevices[i]);
-    }
+    // Follow the transmit queue of both devices of every link
+    QueueMonitor monitor(topo, &logSink, Seconds(sampleInterval));
+    queueMonitor = &monitor;
 
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    // Global routing, or the incremental router when links fail during the run
+    std::unique_ptr<IncrementalRouter> router = SetUpRouting(topo, options.linkEvents);
 
     // UDP Echo Server and Clients
     UdpEchoServerHelper echoServer(9);
-    for (uint32_t i = 0; i < 7; ++i) {
+    for (uint32_t i = 0; i < hosts.GetN(); ++i) {
         echoServer.Install(hosts.Get(i));
     }
 
-    UdpEchoClientHelper echoClient(Ipv4Address("10.1.0.1"), 9);
-    echoClient.SetAttribute("MaxPackets", UintegerValue(2000));
-    echoClient.SetAttribute("Interval", TimeValue(Seconds(0.01)));
-    echoClient.SetAttribute("PacketSize", UintegerValue(2048));
-    for (uint32_t i = 1; i < 7; ++i) {
+    // Every other host echoes with host A, or with EchoPairs host i with host
+    // i + N/2, which spreads the load over the network as N grows
+    uint32_t n = hosts.GetN();
+    for (uint32_t i = echoPairs ? 0 : 1; i < n; ++i) {
+        uint32_t peer = echoPairs ? (i + n / 2) % n : 0;
+        if (peer == i) {
+            continue;
+        }
+        UdpEchoClientHelper echoClient(topo.HostAddress(peer), 9);
+        echoClient.SetAttribute("MaxPackets", UintegerValue(options.maxPackets));
+        echoClient.SetAttribute("Interval", TimeValue(Seconds(options.interval)));
+        echoClient.SetAttribute("PacketSize", UintegerValue(options.packetSize));
         echoClient.Install(hosts.Get(i));
     }
 
-    Simulator::Stop(Seconds(20.0));
+    logSink.Start(&WriteQueueSamples);
+    logSink.StopOnDestroy();
+
+    Simulator::Stop(Seconds(options.stopTime));
+    RunProfiler profiler(topo, options.profile);
     Simulator::Run();
+    profiler.Finish(std::cout);
+    if (router && !router->WriteLinkChanges(options.outputDir + "/link_changes.txt")) {
+        std::cerr << "Error writing link_changes.txt!" << std::endl;
+    }
+    monitor.Finish(Simulator::Now());
+    if (!monitor.WriteSummaryCsv(options.outputDir + "/queue_summary.csv")) {
+        std::cerr << "Error: Could not write queue_summary.csv" << std::endl;
+    }
     Simulator::Destroy();
+    logFile.close();
 
     return 0;
 }
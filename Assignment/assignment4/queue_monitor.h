@@ -0,0 +1,165 @@
+#ifndef QUEUE_MONITOR_H
+#define QUEUE_MONITOR_H
+
+// Watches the transmit queue of both devices of every point-to-point link
+// through the queue's PacketsInQueue trace, so it sees every change without
+// scheduling any polling events. Per queue it keeps the time-weighted mean,
+// the maximum and the time spent at each occupancy (for time-weighted
+// percentiles). Queues are numbered like NodeAliasTable interfaces: link * 2
+// + side, side 0 being the link's 'a' end.
+//
+// The time series goes to an AsyncTraceSink<QueueSample>, either as every
+// change (sampleInterval 0) or as one sample per queue per interval holding
+// the occupancy at the interval's end and the maximum reached within it.
+// Interval samples are emitted lazily from the next change (and by Finish()),
+// so an idle queue costs nothing until it moves again.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+#include "async_trace_sink.h"
+#include "run_profiler.h"
+#include "topology_builder.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+struct QueueSample {
+    int64_t timeNs;
+    uint32_t queue;
+    uint32_t packets;
+    uint32_t maxPackets;   // highest occupancy since the previous sample
+};
+
+class QueueMonitor {
+public:
+    QueueMonitor(const Topology& topo, AsyncTraceSink<QueueSample>* sink, Time sampleInterval)
+        : m_sink(sink), m_intervalNs(sampleInterval.GetNanoSeconds()), m_queues(topo.links.size() * 2) {
+        int64_t now = Simulator::Now().GetNanoSeconds();
+        for (uint32_t link = 0; link < topo.links.size(); ++link) {
+            for (uint32_t side = 0; side < 2; ++side) {
+                QueueState& state = m_queues[link * 2 + side];
+                state.name = side == 0 ? topo.links[link].a + " -> " + topo.links[link].b
+                                       : topo.links[link].b + " -> " + topo.links[link].a;
+                state.lastChangeNs = now;
+                state.nextSampleNs = now + m_intervalNs;
+                Ptr<PointToPointNetDevice> device =
+                    DynamicCast<PointToPointNetDevice>(topo.linkDevices[link].Get(side));
+                if (device) {
+                    device->GetQueue()->TraceConnectWithoutContext(
+                        "PacketsInQueue", MakeBoundCallback(&QueueMonitor::Changed, this, link * 2 + side));
+                }
+            }
+        }
+    }
+
+    uint32_t GetNQueues() const { return m_queues.size(); }
+    const std::string& Name(uint32_t queue) const { return m_queues[queue].name; }
+
+    // Closes every queue's statistics (and pending interval samples) at 'end'
+    void Finish(Time end) {
+        int64_t endNs = end.GetNanoSeconds();
+        for (uint32_t q = 0; q < m_queues.size(); ++q) {
+            Advance(q, endNs);
+        }
+    }
+
+    double Mean(uint32_t queue) const {
+        const QueueState& s = m_queues[queue];
+        int64_t total = TotalNs(s);
+        return total > 0 ? s.areaNs / total : 0.0;
+    }
+
+    uint32_t Max(uint32_t queue) const { return m_queues[queue].max; }
+
+    // Smallest occupancy the queue was at or below for 'fraction' of the time
+    uint32_t Percentile(uint32_t queue, double fraction) const {
+        const QueueState& s = m_queues[queue];
+        double target = fraction * TotalNs(s);
+        int64_t cumulative = 0;
+        for (uint32_t level = 0; level < s.timeAtLevelNs.size(); ++level) {
+            cumulative += s.timeAtLevelNs[level];
+            if (cumulative >= target) {
+                return level;
+            }
+        }
+        return s.max;
+    }
+
+    bool WriteSummaryCsv(const std::string& path) const {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << std::setprecision(9) << "queue,mean_packets,max_packets,p50_packets,p95_packets,p99_packets\n";
+        for (uint32_t q = 0; q < m_queues.size(); ++q) {
+            file << m_queues[q].name << "," << Mean(q) << "," << Max(q) << "," << Percentile(q, 0.5) << ","
+                 << Percentile(q, 0.95) << "," << Percentile(q, 0.99) << "\n";
+        }
+        return file.good();
+    }
+
+private:
+    struct QueueState {
+        std::string name;
+        uint32_t current = 0;
+        uint32_t max = 0;
+        uint32_t intervalMax = 0;
+        int64_t lastChangeNs = 0;
+        int64_t nextSampleNs = 0;
+        double areaNs = 0;                    // integral of occupancy over time
+        std::vector<int64_t> timeAtLevelNs;   // indexed by occupancy
+    };
+
+    static void Changed(QueueMonitor* monitor, uint32_t queue, uint32_t, uint32_t newValue) {
+        ++TraceCallbackCount();
+        int64_t now = Simulator::Now().GetNanoSeconds();
+        monitor->Advance(queue, now);
+        QueueState& s = monitor->m_queues[queue];
+        s.current = newValue;
+        s.max = std::max(s.max, newValue);
+        s.intervalMax = std::max(s.intervalMax, newValue);
+        if (monitor->m_intervalNs <= 0) {
+            monitor->m_sink->Push({now, queue, newValue, newValue});
+        }
+    }
+
+    // Accounts for the time the queue spent at its current level up to 'now'
+    void Advance(uint32_t queue, int64_t now) {
+        QueueState& s = m_queues[queue];
+        if (m_intervalNs > 0) {
+            while (s.nextSampleNs <= now) {
+                m_sink->Push({s.nextSampleNs, queue, s.current, s.intervalMax});
+                s.intervalMax = s.current;
+                s.nextSampleNs += m_intervalNs;
+            }
+        }
+        int64_t dt = now - s.lastChangeNs;
+        if (dt > 0) {
+            if (s.timeAtLevelNs.size() <= s.current) {
+                s.timeAtLevelNs.resize(s.current + 1, 0);
+            }
+            s.timeAtLevelNs[s.current] += dt;
+            s.areaNs += double(s.current) * dt;
+            s.lastChangeNs = now;
+        }
+    }
+
+    static int64_t TotalNs(const QueueState& s) {
+        int64_t total = 0;
+        for (int64_t t : s.timeAtLevelNs) {
+            total += t;
+        }
+        return total;
+    }
+
+    AsyncTraceSink<QueueSample>* m_sink;
+    int64_t m_intervalNs;
+    std::vector<QueueState> m_queues;
+};
+
+#endif // QUEUE_MONITOR_H
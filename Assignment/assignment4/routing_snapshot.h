@@ -0,0 +1,217 @@
+#ifndef ROUTING_SNAPSHOT_H
+#define ROUTING_SNAPSHOT_H
+
+// Captures every node's IPv4 routing table at chosen times and writes only
+// what changed since the previous capture, one line per route:
+//   <time>s <node> + <dest> via <gateway> if <interface> from <protocol>/<priority>   (new route)
+//   <time>s <node> - <dest> via <gateway> if <interface> from <protocol>/<priority>   (route gone)
+//   <time>s <node> ~ <dest> via <gateway> if <interface> from <protocol>/<priority>   (new next hop)
+// The first capture lists every route as new. Tables are read through global,
+// static, incremental (incremental_router.h) and list routing (recursively),
+// so it works whichever protocol the stack uses; <priority> is the list
+// routing priority the route's protocol was added with (0 outside a list).
+// Routes are kept as sorted integer tuples, one vector per node. A (dest,
+// mask) may have several routes, from different protocols or as equal-cost
+// alternatives; it is reported as re-routed (~) only when it had one route
+// before and after, otherwise as the routes that went and came.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "incremental_router.h"
+#include "topology_builder.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace ns3;
+
+struct RouteEntry {
+    enum Protocol : uint8_t { kGlobal, kIncremental, kStatic };
+
+    uint32_t dest;
+    uint32_t mask;
+    uint8_t protocol;
+    int16_t priority;
+    uint32_t gateway;
+    uint32_t interface;
+
+    bool operator<(const RouteEntry& o) const {
+        return std::tie(dest, mask, protocol, priority, gateway, interface) <
+               std::tie(o.dest, o.mask, o.protocol, o.priority, o.gateway, o.interface);
+    }
+    bool operator==(const RouteEntry& o) const { return !(*this < o) && !(o < *this); }
+    bool SameDest(const RouteEntry& o) const { return dest == o.dest && mask == o.mask; }
+};
+
+class RoutingSnapshotter {
+public:
+    RoutingSnapshotter(const Topology& topo, const std::string& path)
+        : m_topo(topo), m_file(path), m_tables(topo.nodes.GetN()) {}
+
+    bool IsOpen() const { return m_file.is_open(); }
+
+    void ScheduleAt(Time when) {
+        Simulator::Schedule(when - Simulator::Now(), &RoutingSnapshotter::Capture, this);
+    }
+
+    // Reads every table now, writes the differences and keeps the new tables
+    uint32_t Capture() {
+        uint32_t changes = 0;
+        double now = Simulator::Now().GetSeconds();
+        for (uint32_t i = 0; i < m_topo.nodes.GetN(); ++i) {
+            std::vector<RouteEntry> table;
+            Ptr<Ipv4> ipv4 = m_topo.nodes.Get(i)->GetObject<Ipv4>();
+            if (ipv4) {
+                Collect(ipv4->GetRoutingProtocol(), table);
+            }
+            std::sort(table.begin(), table.end());
+            table.erase(std::unique(table.begin(), table.end()), table.end());
+            changes += Diff(now, i, m_tables[i], table);
+            m_tables[i].swap(table);
+        }
+        m_file.flush();
+        ++m_captures;
+        return changes;
+    }
+
+    uint32_t GetCaptures() const { return m_captures; }
+
+private:
+    static void Append(const Ipv4RoutingTableEntry& route, RouteEntry::Protocol protocol, int16_t priority,
+                       std::vector<RouteEntry>& table) {
+        table.push_back({route.GetDest().Get(), route.GetDestNetworkMask().Get(), protocol, priority,
+                         route.GetGateway().Get(), route.GetInterface()});
+    }
+
+    static void Collect(Ptr<Ipv4RoutingProtocol> protocol, std::vector<RouteEntry>& table, int16_t priority = 0) {
+        if (Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(protocol)) {
+            for (uint32_t i = 0; i < list->GetNRoutingProtocols(); ++i) {
+                int16_t listPriority;
+                Ptr<Ipv4RoutingProtocol> member = list->GetRoutingProtocol(i, listPriority);
+                Collect(member, table, listPriority);
+            }
+        } else if (Ptr<Ipv4GlobalRouting> global = DynamicCast<Ipv4GlobalRouting>(protocol)) {
+            for (uint32_t i = 0; i < global->GetNRoutes(); ++i) {
+                Append(*global->GetRoute(i), RouteEntry::kGlobal, priority, table);
+            }
+        } else if (Ptr<IncrementalRouting> incremental = DynamicCast<IncrementalRouting>(protocol)) {
+            for (const Ipv4RoutingTableEntry& route : incremental->GetRoutes()) {
+                Append(route, RouteEntry::kIncremental, priority, table);
+            }
+        } else if (Ptr<Ipv4StaticRouting> staticRouting = DynamicCast<Ipv4StaticRouting>(protocol)) {
+            for (uint32_t i = 0; i < staticRouting->GetNRoutes(); ++i) {
+                Append(staticRouting->GetRoute(i), RouteEntry::kStatic, priority, table);
+            }
+        }
+    }
+
+    // Both tables are sorted by (dest, mask) first, so one merge pass over
+    // the (dest, mask) groups finds added, removed and re-routed destinations.
+    // Groups present on both sides are compared as sets.
+    uint32_t Diff(double now, uint32_t node, const std::vector<RouteEntry>& before,
+                  const std::vector<RouteEntry>& after) {
+        uint32_t changes = 0;
+        size_t i = 0;
+        size_t j = 0;
+        while (i < before.size() || j < after.size()) {
+            if (j == after.size() ||
+                (i < before.size() && std::tie(before[i].dest, before[i].mask) <
+                                          std::tie(after[j].dest, after[j].mask))) {
+                Write(now, node, '-', before[i++]);
+                ++changes;
+                continue;
+            }
+            if (i == before.size() || !before[i].SameDest(after[j])) {
+                Write(now, node, '+', after[j++]);
+                ++changes;
+                continue;
+            }
+            size_t iEnd = i;
+            size_t jEnd = j;
+            while (iEnd < before.size() && before[iEnd].SameDest(before[i])) {
+                ++iEnd;
+            }
+            while (jEnd < after.size() && after[jEnd].SameDest(after[j])) {
+                ++jEnd;
+            }
+            if (iEnd - i == 1 && jEnd - j == 1) {
+                if (!(before[i] == after[j])) {
+                    Write(now, node, '~', after[j]);
+                    ++changes;
+                }
+            } else {
+                // Both groups are sorted, so a second merge pass splits them
+                // into the routes that went and the ones that came
+                while (i < iEnd || j < jEnd) {
+                    if (j == jEnd || (i < iEnd && before[i] < after[j])) {
+                        Write(now, node, '-', before[i]);
+                        ++changes;
+                        ++i;
+                    } else if (i == iEnd || after[j] < before[i]) {
+                        Write(now, node, '+', after[j]);
+                        ++changes;
+                        ++j;
+                    } else {
+                        ++i;
+                        ++j;
+                    }
+                }
+            }
+            i = iEnd;
+            j = jEnd;
+        }
+        return changes;
+    }
+
+    void Write(double now, uint32_t node, char change, const RouteEntry& route) {
+        m_file << now << "s " << m_topo.names[node] << " " << change << " " << DestName(route) << " via "
+               << (route.gateway == 0 ? std::string("direct") : AddressName(route.gateway)) << " if "
+               << route.interface << " from " << ProtocolName(route.protocol) << "/" << route.priority << "\n";
+    }
+
+    static const char* ProtocolName(uint8_t protocol) {
+        switch (protocol) {
+        case RouteEntry::kGlobal:
+            return "global";
+        case RouteEntry::kIncremental:
+            return "incremental";
+        default:
+            return "static";
+        }
+    }
+
+    // Host routes by node name, link subnets as [a - b], anything else as address/prefix
+    std::string DestName(const RouteEntry& route) const {
+        if (route.mask == 0xffffffff) {
+            return AddressName(route.dest);
+        }
+        uint32_t link = m_topo.aliases.plan.LinkOfSubnet(route.dest, route.mask);
+        if (link < m_topo.links.size()) {
+            return "[" + m_topo.LinkName(link) + "]";
+        }
+        std::ostringstream name;
+        name << Ipv4Address(route.dest) << "/" << Ipv4Mask(route.mask).GetPrefixLength();
+        return name.str();
+    }
+
+    std::string AddressName(uint32_t address) const {
+        uint32_t alias = m_topo.aliases.ForAddress(Ipv4Address(address));
+        if (alias != NodeAliasTable::kUnknown) {
+            return m_topo.aliases.Name(alias);
+        }
+        std::ostringstream name;
+        name << Ipv4Address(address);
+        return name.str();
+    }
+
+    const Topology& m_topo;
+    std::ofstream m_file;
+    std::vector<std::vector<RouteEntry>> m_tables;
+    uint32_t m_captures = 0;
+};
+
+#endif // ROUTING_SNAPSHOT_H
@@ -0,0 +1,177 @@
+#ifndef RUN_PROFILER_H
+#define RUN_PROFILER_H
+
+// Where a run's time goes, reported after Simulator::Run() with --Profile.
+// The totals come from the simulator (events executed, simulated time), the
+// wall clock around Run() and the process's peak resident set (getrusage).
+// The breakdown counts the per-packet work the events did, from trace
+// sources that are hooked only when profiling:
+//   app send         packets the applications handed to their sockets (Tx)
+//   p2p transmit     transmissions started by point-to-point devices
+//   queue            enqueues and dequeues, device queues and queue discs
+//   flowmon probe    IPv4 send/forward/deliver/drop hits, where FlowMonitor's
+//                    probe does its per-packet work when it is installed
+//   trace callbacks  calls into this directory's collectors, which count
+//                    themselves with ++TraceCallbackCount() (always on, it is
+//                    one increment)
+// Besides the table it prints a single "profile key=value ..." line for the
+// benchmark scripts. In a distributed run the counts are summed over the
+// ranks and the wall time and peak memory are the largest of any rank.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+#include "distributed.h"
+#include "topology_builder.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sys/resource.h>
+
+using namespace ns3;
+
+inline uint64_t& TraceCallbackCount() {
+    static uint64_t count = 0;
+    return count;
+}
+
+// Peak resident set of this process so far, in kB
+inline uint64_t PeakRssKb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;   // bytes there
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+class RunProfiler {
+public:
+    // Construct right before Simulator::Run(), once the applications are
+    // installed; does nothing unless 'enabled'
+    RunProfiler(const Topology& topo, bool enabled) : m_enabled(enabled) {
+        if (!m_enabled) {
+            return;
+        }
+        for (uint32_t i = 0; i < topo.nodes.GetN(); ++i) {
+            Ptr<Node> node = topo.nodes.Get(i);
+            for (uint32_t a = 0; a < node->GetNApplications(); ++a) {
+                // Sources without a Tx trace (PacketSink) just do not connect
+                node->GetApplication(a)->TraceConnectWithoutContext(
+                    "Tx", MakeBoundCallback(&RunProfiler::CountPacket, &m_counts[kAppSend]));
+            }
+            Ptr<Ipv4L3Protocol> ipv4 = node->GetObject<Ipv4L3Protocol>();
+            if (ipv4) {
+                ipv4->TraceConnectWithoutContext("SendOutgoing",
+                                                 MakeBoundCallback(&RunProfiler::CountIp, &m_counts[kProbe]));
+                ipv4->TraceConnectWithoutContext("UnicastForward",
+                                                 MakeBoundCallback(&RunProfiler::CountIp, &m_counts[kProbe]));
+                ipv4->TraceConnectWithoutContext("LocalDeliver",
+                                                 MakeBoundCallback(&RunProfiler::CountIp, &m_counts[kProbe]));
+                ipv4->TraceConnectWithoutContext("Drop",
+                                                 MakeBoundCallback(&RunProfiler::CountIpDrop, &m_counts[kProbe]));
+            }
+        }
+        for (const NetDeviceContainer& devices : topo.linkDevices) {
+            for (uint32_t side = 0; side < devices.GetN(); ++side) {
+                Ptr<PointToPointNetDevice> device = DynamicCast<PointToPointNetDevice>(devices.Get(side));
+                if (!device) {
+                    continue;
+                }
+                device->TraceConnectWithoutContext("PhyTxBegin",
+                                                   MakeBoundCallback(&RunProfiler::CountPacket, &m_counts[kTransmit]));
+                for (const char* source : {"Enqueue", "Dequeue"}) {
+                    device->GetQueue()->TraceConnectWithoutContext(
+                        source, MakeBoundCallback(&RunProfiler::CountPacket, &m_counts[kQueue]));
+                }
+                Ptr<TrafficControlLayer> tc = device->GetNode()->GetObject<TrafficControlLayer>();
+                Ptr<QueueDisc> disc = tc ? tc->GetRootQueueDiscOnDevice(device) : nullptr;
+                if (disc) {
+                    for (const char* source : {"Enqueue", "Dequeue"}) {
+                        disc->TraceConnectWithoutContext(
+                            source, MakeBoundCallback(&RunProfiler::CountItem, &m_counts[kQueue]));
+                    }
+                }
+            }
+        }
+        m_events = Simulator::GetEventCount();
+        m_callbacks = TraceCallbackCount();
+        m_simStart = Simulator::Now();
+        m_wallStart = std::chrono::steady_clock::now();
+    }
+
+    // Call right after Simulator::Run(); prints the report to 'os' (on rank 0
+    // of a distributed run, but every rank must call it)
+    void Finish(std::ostream& os) {
+        if (!m_enabled) {
+            return;
+        }
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_wallStart).count();
+        double simulated = (Simulator::Now() - m_simStart).GetSeconds();
+        m_counts[kEvents] = Simulator::GetEventCount() - m_events;
+        m_counts[kCallbacks] = TraceCallbackCount() - m_callbacks;
+        double peaks[2] = {wall, double(PeakRssKb())};
+        ReduceToRoot(m_counts, kCounts);
+        ReduceToRoot(peaks, 2, RankReduce::kMax);
+        if (MpiRank() != 0) {
+            return;
+        }
+        wall = peaks[0];
+        uint64_t rssKb = uint64_t(peaks[1]);
+        double eventsPerSecond = wall > 0 ? m_counts[kEvents] / wall : 0;
+        double ratio = wall > 0 ? simulated / wall : 0;
+        const char* names[kCounts] = {"events", "app send", "p2p transmit", "queue", "flowmon probe",
+                                      "trace callbacks"};
+        const char* keys[kCounts] = {"events", "app_send", "p2p_tx", "queue", "flowmon_probe", "trace_callbacks"};
+        std::ios::fmtflags flags = os.flags();
+        std::streamsize precision = os.precision();
+
+        os << "Run profile" << (MpiSize() > 1 ? " (all ranks)" : "") << ":\n"
+           << std::fixed << std::setprecision(3)
+           << "  events executed   " << std::setw(14) << m_counts[kEvents] << "\n"
+           << "  wall time         " << std::setw(14) << wall << " s\n"
+           << "  simulated time    " << std::setw(14) << simulated << " s\n"
+           << "  events/s          " << std::setw(14) << std::setprecision(0) << eventsPerSecond << "\n"
+           << "  simulated/wall    " << std::setw(14) << std::setprecision(3) << ratio << "\n"
+           << "  peak RSS          " << std::setw(14) << rssKb << " kB\n"
+           << "  per-packet work:\n";
+        for (uint32_t c = kAppSend; c < kCounts; ++c) {
+            os << "    " << std::left << std::setw(16) << names[c] << std::right << std::setw(14) << m_counts[c]
+               << "\n";
+        }
+        os << std::setprecision(6) << "profile events=" << m_counts[kEvents] << " wall_s=" << wall
+           << " sim_s=" << simulated << " events_per_s=" << std::setprecision(0) << eventsPerSecond
+           << " sim_wall_ratio=" << std::setprecision(6) << ratio << " peak_rss_kb=" << rssKb;
+        for (uint32_t c = kAppSend; c < kCounts; ++c) {
+            os << " " << keys[c] << "=" << m_counts[c];
+        }
+        os << std::endl;
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+private:
+    enum Count { kEvents, kAppSend, kTransmit, kQueue, kProbe, kCallbacks, kCounts };
+
+    static void CountPacket(uint64_t* count, Ptr<const Packet>) { ++*count; }
+    static void CountItem(uint64_t* count, Ptr<const QueueDiscItem>) { ++*count; }
+    static void CountIp(uint64_t* count, const Ipv4Header&, Ptr<const Packet>, uint32_t) { ++*count; }
+    static void CountIpDrop(uint64_t* count, const Ipv4Header&, Ptr<const Packet>, Ipv4L3Protocol::DropReason,
+                            Ptr<Ipv4>, uint32_t) {
+        ++*count;
+    }
+
+    bool m_enabled;
+    uint64_t m_counts[kCounts] = {};
+    uint64_t m_events = 0;
+    uint64_t m_callbacks = 0;
+    Time m_simStart;
+    std::chrono::steady_clock::time_point m_wallStart;
+};
+
+#endif // RUN_PROFILER_H
@@ -0,0 +1,72 @@
+#ifndef RUNNING_STATS_H
+#define RUNNING_STATS_H
+
+// Constant-memory statistics over a stream of samples: Welford's running mean
+// and variance, and a fixed-width histogram with an overflow bin. Plain C++,
+// no ns-3.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct RunningStats {
+    uint64_t count = 0;
+    double mean = 0;
+    double m2 = 0;   // sum of squared deviations from the mean
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void Add(double x) {
+        ++count;
+        double delta = x - mean;
+        mean += delta / count;
+        m2 += delta * (x - mean);
+        if (x < min) {
+            min = x;
+        }
+        if (x > max) {
+            max = x;
+        }
+    }
+
+    // Population variance; 0 until there are two samples
+    double Variance() const { return count > 1 ? m2 / count : 0.0; }
+
+    // Chan et al.'s pairwise combination, for merging runs or partitions
+    void Merge(const RunningStats& other) {
+        if (other.count == 0) {
+            return;
+        }
+        if (count == 0) {
+            *this = other;
+            return;
+        }
+        uint64_t total = count + other.count;
+        double delta = other.mean - mean;
+        mean += delta * other.count / total;
+        m2 += other.m2 + delta * delta * (double(count) * other.count / total);
+        count = total;
+        min = other.min < min ? other.min : min;
+        max = other.max > max ? other.max : max;
+    }
+};
+
+// 'bins' buckets of 'binWidth' starting at 0; larger samples land in the last
+struct Histogram {
+    double binWidth = 0;
+    std::vector<uint64_t> counts;
+
+    Histogram() = default;
+    Histogram(double width, uint32_t bins) : binWidth(width), counts(bins, 0) {}
+
+    void Add(double x) {
+        if (counts.empty()) {
+            return;
+        }
+        double bin = x > 0 ? x / binWidth : 0;
+        counts[bin < counts.size() - 1 ? size_t(bin) : counts.size() - 1]++;
+    }
+};
+
+#endif // RUNNING_STATS_H
@@ -0,0 +1,157 @@
+// Parameter sweep driver for packet_drop and end_to_end_delay. Expands a grid
+// of ErrorRate x Interval x PacketSize x MaxPackets x RngRun values, runs every
+// point of every experiment as its own process across all cores, then merges
+// the per-run CSV matrices into one long-format table:
+//
+//   ./sweep_runner --ErrorRate=0.01,0.05 --Interval=0.01,0.02 --runs=5 --out=sweep
+//
+// writes sweep/results.csv with one row per (run, src, dst, metric). Each run
+// gets its own directory under --out holding its output files and run.log.
+//
+// Runs are launched through --command, where {exp} is replaced by the
+// experiment name and {args} by its command-line options. The default uses
+// the ns3 wrapper; point it at the built binaries directly to skip it.
+#include "process_pool.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct SweepPoint {
+    std::string experiment;
+    std::string errorRate;
+    std::string interval;
+    std::string packetSize;
+    std::string maxPackets;
+    std::string rngRun;
+    std::string outputDir;
+};
+
+static std::vector<std::string> SplitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static std::string ReplaceAll(std::string text, const std::string& from, const std::string& to) {
+    for (size_t pos = text.find(from); pos != std::string::npos; pos = text.find(from, pos + to.size())) {
+        text.replace(pos, from.size(), to);
+    }
+    return text;
+}
+
+// Appends every data row of 'csvPath' ("src,dst,<metric>...") to 'out' as one
+// row per metric, prefixed with the sweep point. Returns false if unreadable.
+static bool MergeCsv(const std::string& csvPath, const SweepPoint& point, std::ostream& out) {
+    std::ifstream csv(csvPath);
+    std::string line;
+    if (!csv.is_open() || !std::getline(csv, line)) {
+        return false;
+    }
+    std::vector<std::string> header = SplitList(line);
+    while (std::getline(csv, line)) {
+        std::vector<std::string> fields = SplitList(line);
+        for (size_t i = 2; i < fields.size() && i < header.size(); ++i) {
+            out << point.experiment << "," << point.errorRate << "," << point.interval << ","
+                << point.packetSize << "," << point.maxPackets << "," << point.rngRun << ","
+                << fields[0] << "," << fields[1] << "," << header[i] << "," << fields[i] << "\n";
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    std::map<std::string, std::string> options = {
+        {"experiments", "packet_drop,end_to_end_delay"},
+        {"ErrorRate", "0.01"},
+        {"Interval", "0.01"},
+        {"PacketSize", "1024"},
+        {"MaxPackets", "1000"},
+        {"runs", "1"},
+        {"jobs", std::to_string(std::max(1u, std::thread::hardware_concurrency()))},
+        {"out", "sweep"},
+        {"command", "./ns3 run --no-build \"{exp} {args}\""},
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos || !options.count(arg.substr(2, eq - 2))) {
+            std::cerr << "Usage: " << argv[0] << " [--name=value ...]; known options:" << std::endl;
+            for (const auto& option : options) {
+                std::cerr << "  --" << option.first << " (default " << option.second << ")" << std::endl;
+            }
+            return 1;
+        }
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+
+    std::filesystem::path outDir = std::filesystem::absolute(options["out"]);
+    // The run directories go into the command line, inside the double quotes
+    // of the default ns3 template
+    if (!SafeInDoubleQuotes(outDir.string())) {
+        std::cerr << "Error: --out path " << outDir << " must not contain $, `, \" or \\" << std::endl;
+        return 1;
+    }
+    std::vector<SweepPoint> points;
+    uint32_t runs = std::stoul(options["runs"]);
+    for (const auto& experiment : SplitList(options["experiments"])) {
+        for (const auto& errorRate : SplitList(options["ErrorRate"])) {
+            for (const auto& interval : SplitList(options["Interval"])) {
+                for (const auto& packetSize : SplitList(options["PacketSize"])) {
+                    for (const auto& maxPackets : SplitList(options["MaxPackets"])) {
+                        for (uint32_t run = 1; run <= runs; ++run) {
+                            SweepPoint point{experiment, errorRate, interval, packetSize, maxPackets,
+                                             std::to_string(run), ""};
+                            point.outputDir = (outDir / (std::to_string(points.size()) + "-" + experiment)).string();
+                            points.push_back(point);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    ProcessPool pool(std::stoul(options["jobs"]));
+    for (const auto& point : points) {
+        std::filesystem::create_directories(point.outputDir);
+        std::string args = "--ErrorRate=" + point.errorRate + " --Interval=" + point.interval +
+                           " --PacketSize=" + point.packetSize + " --MaxPackets=" + point.maxPackets +
+                           " --RngRun=" + point.rngRun + " --OutputDir=" + ShellQuote(point.outputDir);
+        std::string command = ReplaceAll(ReplaceAll(options["command"], "{exp}", point.experiment), "{args}", args);
+        pool.Add(command + " > " + ShellQuote(point.outputDir + "/run.log") + " 2>&1");
+    }
+
+    std::cout << "Running " << points.size() << " simulations on " << options["jobs"] << " workers" << std::endl;
+    size_t done = 0;
+    std::vector<ProcessResult> results = pool.Run([&done, &points](const ProcessResult& result) {
+        ++done;
+        std::cout << "[" << done << "/" << points.size() << "] " << points[result.id].outputDir
+                  << (result.exitCode == 0 ? " ok " : " FAILED ") << result.wallSeconds << "s" << std::endl;
+    });
+
+    std::ofstream table(outDir / "results.csv");
+    table << "experiment,ErrorRate,Interval,PacketSize,MaxPackets,RngRun,src,dst,metric,value\n";
+    uint32_t failures = 0;
+    for (const auto& result : results) {
+        const SweepPoint& point = points[result.id];
+        std::string csv = point.outputDir + "/" +
+                          (point.experiment == "packet_drop" ? "packet_drop.csv" : "delay_calculation.csv");
+        if (result.exitCode != 0 || !MergeCsv(csv, point, table)) {
+            std::cerr << "Error: no results from " << point.outputDir << " (see run.log)" << std::endl;
+            ++failures;
+        }
+    }
+    std::cout << "Merged " << (results.size() - failures) << " runs into " << (outDir / "results.csv").string()
+              << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,252 @@
+#ifndef TOPOLOGY_BUILDER_H
+#define TOPOLOGY_BUILDER_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/traffic-control-module.h"
+#include "address_planner.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+// One row of the link table: the two endpoints by name, the p2p attributes
+// and an optional loss spec (see error_models.h; empty means the experiment's
+// default). The 'a' side of a host link is always the host, so device 0 /
+// interface 0 of that link belong to the host.
+struct LinkSpec {
+    std::string a;
+    std::string b;
+    std::string dataRate;
+    std::string delay;
+    std::string loss;
+};
+
+// Integer-indexed node names for per-packet callbacks. An alias id is the
+// node's topology index; callbacks record ids and names are looked up only
+// when output is written. Interfaces are indexed densely as link * 2 + side,
+// which the address plan recovers from an address arithmetically.
+struct NodeAliasTable {
+    static constexpr uint32_t kUnknown = 0xffffffff;
+
+    std::vector<std::string> names;   // alias id -> name
+    std::vector<uint32_t> byNodeId;   // ns-3 node id -> alias id
+    std::vector<uint32_t> byInterface; // link * 2 + side -> alias id
+    AddressPlanner plan;
+
+    uint32_t ForNode(uint32_t nodeId) const {
+        return nodeId < byNodeId.size() ? byNodeId[nodeId] : kUnknown;
+    }
+
+    uint32_t ForAddress(Ipv4Address address) const {
+        uint32_t iface = plan.InterfaceOf(address.Get());
+        return iface < byInterface.size() ? byInterface[iface] : kUnknown;
+    }
+
+    // The link an interface address belongs to, kUnknown for other addresses
+    uint32_t LinkForAddress(Ipv4Address address) const {
+        uint32_t iface = plan.InterfaceOf(address.Get());
+        return iface < byInterface.size() ? iface / 2 : kUnknown;
+    }
+
+    const std::string& Name(uint32_t alias) const {
+        static const std::string unknown = "Unknown";
+        return alias < names.size() ? names[alias] : unknown;
+    }
+};
+
+// The built network. Node indexes are positions in 'nodes' (hosts first, then
+// routers) and line up with 'names'; link indexes line up with the link table.
+struct Topology {
+    NodeContainer nodes;
+    NodeContainer hosts;
+    NodeContainer routers;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> index;
+    std::vector<LinkSpec> links;
+    std::vector<std::pair<uint32_t, uint32_t>> linkEnds;
+    std::vector<NetDeviceContainer> linkDevices;
+    std::vector<Ipv4InterfaceContainer> linkInterfaces;
+    std::vector<Ipv4Address> primaryAddress; // node index -> address on its first link
+    NodeAliasTable aliases;
+
+    uint32_t Index(const std::string& name) const {
+        auto it = index.find(name);
+        NS_ABORT_MSG_IF(it == index.end(), "Unknown node '" << name << "' in link table");
+        return it->second;
+    }
+
+    uint32_t GetNHosts() const { return hosts.GetN(); }
+
+    // Address other hosts should use to reach host 'i'
+    Ipv4Address HostAddress(uint32_t i) const { return primaryAddress[i]; }
+
+    std::string LinkName(uint32_t link) const {
+        return names[linkEnds[link].first] + " - " + names[linkEnds[link].second];
+    }
+};
+
+// The A-G / R1-R4 network with the capacities from Table 3 of the assignment;
+// topology_generator.h builds larger ones.
+inline std::vector<std::string> DefaultHostNames() {
+    return {"A", "B", "C", "D", "E", "F", "G"};
+}
+
+inline std::vector<std::string> DefaultRouterNames() {
+    return {"R1", "R2", "R3", "R4"};
+}
+
+inline std::vector<LinkSpec> DefaultLinkTable() {
+    return {
+        {"A", "R1", "1Mbps", "2ms"},
+        {"B", "R1", "1Mbps", "2ms"},
+        {"C", "R3", "1Mbps", "2ms"},
+        {"D", "R3", "2Mbps", "2ms"},
+        {"E", "R2", "1Mbps", "2ms"},
+        {"F", "R2", "1Mbps", "2ms"},
+        {"G", "R4", "1Mbps", "2ms"},
+        {"R1", "R2", "3Mbps", "2ms"},
+        {"R1", "R3", "2.5Mbps", "2ms"},
+        {"R3", "R4", "1.5Mbps", "2ms"},
+        {"R2", "R4", "1Mbps", "2ms"},
+    };
+}
+
+// Reads a link table file. Each non-comment line is either a link,
+// "<a> <b> <dataRate> <delay> [<loss>]", or "host <name>..." / "router <name>...",
+// which replace the default node lists. Links always replace 'links'.
+inline void LoadLinkTable(const std::string& path, std::vector<std::string>& hostNames,
+                          std::vector<std::string>& routerNames, std::vector<LinkSpec>& links) {
+    std::ifstream file(path);
+    NS_ABORT_MSG_IF(!file.is_open(), "Cannot open link table " << path);
+    bool sawHosts = false;
+    bool sawRouters = false;
+    links.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        std::string first;
+        if (!(fields >> first)) {
+            continue;
+        }
+        if (first == "host" || first == "router") {
+            std::vector<std::string>& names = first == "host" ? hostNames : routerNames;
+            bool& seen = first == "host" ? sawHosts : sawRouters;
+            if (!seen) {
+                names.clear();
+                seen = true;
+            }
+            std::string name;
+            while (fields >> name) {
+                names.push_back(name);
+            }
+            continue;
+        }
+        LinkSpec link;
+        link.a = first;
+        NS_ABORT_MSG_IF(!(fields >> link.b >> link.dataRate >> link.delay),
+                        "Bad link table line in " << path << ": '" << line << "'");
+        fields >> link.loss;
+        links.push_back(link);
+    }
+}
+
+// Creates the nodes, installs 'stack' on all of them, then installs one p2p
+// link per table row and gives it the next subnet of 'plan', in table order
+// (by default link i gets the i-th /30 of 10.0.0.0/8, side a .1 and side b .2
+// of it). Interfaces are added to the stack directly rather than through
+// Ipv4AddressHelper, whose global allocation registry is searched on every
+// address and gets slow past a few thousand links; like the helper, each
+// device still gets the default queue disc. 'systemIds' (node index -> MPI
+// rank, see distributed.h) places the nodes of a distributed run; empty
+// means all on rank 0.
+inline Topology BuildTopology(const std::vector<std::string>& hostNames,
+                              const std::vector<std::string>& routerNames,
+                              const std::vector<LinkSpec>& links,
+                              InternetStackHelper& stack,
+                              const AddressPlanner& plan = AddressPlanner(),
+                              const std::vector<uint32_t>& systemIds = std::vector<uint32_t>()) {
+    NS_ABORT_MSG_IF(links.size() > plan.Capacity(),
+                    links.size() << " links do not fit the address pool (" << plan.Capacity() << " subnets)");
+    Topology topo;
+    for (uint32_t i = 0; i < hostNames.size() + routerNames.size(); ++i) {
+        NodeContainer& group = i < hostNames.size() ? topo.hosts : topo.routers;
+        group.Create(1, i < systemIds.size() ? systemIds[i] : 0);
+    }
+    topo.nodes.Add(topo.hosts);
+    topo.nodes.Add(topo.routers);
+
+    topo.names = hostNames;
+    topo.names.insert(topo.names.end(), routerNames.begin(), routerNames.end());
+    topo.index.reserve(topo.names.size());
+    for (uint32_t i = 0; i < topo.names.size(); ++i) {
+        topo.index[topo.names[i]] = i;
+    }
+    NS_ABORT_MSG_IF(topo.index.size() != topo.names.size(), "Duplicate node name in topology");
+
+    stack.Install(topo.nodes);
+
+    topo.links = links;
+    topo.linkEnds.reserve(links.size());
+    topo.linkDevices.reserve(links.size());
+    topo.linkInterfaces.reserve(links.size());
+    topo.primaryAddress.assign(topo.names.size(), Ipv4Address());
+    std::vector<bool> hasAddress(topo.names.size(), false);
+
+    PointToPointHelper p2p;
+    TrafficControlHelper trafficControl = TrafficControlHelper::Default();
+    const Ipv4Mask mask(plan.Mask());
+
+    topo.aliases.names = topo.names;
+    topo.aliases.plan = plan;
+    topo.aliases.byInterface.reserve(links.size() * 2);
+    for (uint32_t i = 0; i < topo.nodes.GetN(); ++i) {
+        uint32_t nodeId = topo.nodes.Get(i)->GetId();
+        if (nodeId >= topo.aliases.byNodeId.size()) {
+            topo.aliases.byNodeId.resize(nodeId + 1, NodeAliasTable::kUnknown);
+        }
+        topo.aliases.byNodeId[nodeId] = i;
+    }
+
+    for (uint32_t i = 0; i < links.size(); ++i) {
+        const LinkSpec& link = links[i];
+        uint32_t a = topo.Index(link.a);
+        uint32_t b = topo.Index(link.b);
+
+        p2p.SetDeviceAttribute("DataRate", StringValue(link.dataRate));
+        p2p.SetChannelAttribute("Delay", StringValue(link.delay));
+        NetDeviceContainer devices = p2p.Install(topo.nodes.Get(a), topo.nodes.Get(b));
+
+        Ipv4InterfaceContainer interfaces;
+        uint32_t ends[2] = {a, b};
+        for (uint32_t side = 0; side < 2; ++side) {
+            Ptr<Ipv4> ipv4 = topo.nodes.Get(ends[side])->GetObject<Ipv4>();
+            int32_t interface = ipv4->AddInterface(devices.Get(side));
+            ipv4->AddAddress(interface, Ipv4InterfaceAddress(Ipv4Address(plan.Address(i, side)), mask));
+            ipv4->SetMetric(interface, 1);
+            ipv4->SetUp(interface);
+            interfaces.Add(ipv4, interface);
+            if (!hasAddress[ends[side]]) {
+                topo.primaryAddress[ends[side]] = interfaces.GetAddress(side);
+                hasAddress[ends[side]] = true;
+            }
+        }
+
+        trafficControl.Install(devices);
+
+        topo.aliases.byInterface.push_back(a);
+        topo.aliases.byInterface.push_back(b);
+        topo.linkEnds.emplace_back(a, b);
+        topo.linkDevices.push_back(devices);
+        topo.linkInterfaces.push_back(interfaces);
+    }
+    return topo;
+}
+
+#endif // TOPOLOGY_BUILDER_H
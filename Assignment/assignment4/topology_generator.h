@@ -0,0 +1,243 @@
+#ifndef TOPOLOGY_GENERATOR_H
+#define TOPOLOGY_GENERATOR_H
+
+// Generated link tables for scaling runs, in the same form LoadLinkTable()
+// produces. A spec is "<kind>:<key>=<value>,..." with these kinds:
+//   ring:routers=N              N routers in a cycle
+//   grid:width=W,height=H       W x H router mesh, 4-neighbour
+//   waxman:routers=N,alpha=A,beta=B
+//                               routers placed uniformly in the unit square,
+//                               u-v linked with probability
+//                               B * exp(-d(u,v) / (A * sqrt(2))); components
+//                               are then chained so the graph is connected
+//   fattree:k=K                 K-ary fat-tree (K even): (K/2)^2 core, K pods of
+//                               K/2 aggregation and K/2 edge switches, K/2 hosts
+//                               per edge switch
+//   edges:file=PATH             router graph from an edge list, one "u v" pair
+//                               per line ('#' comments); ids are any token
+// Every kind but fattree hangs 'hosts' hosts (default 1) off each router.
+// Common keys: hostRate (1Mbps), coreRate (2Mbps), delay (2ms).
+//
+// Nodes get numeric names, H<i> for hosts and R<i> for routers, and host
+// links come first in host order, so host i's primary address is on link i.
+// Randomness (waxman) is drawn from CounterRng keyed by the ns-3 seed and run.
+
+#include "ns3/core-module.h"
+#include "counter_rng.h"
+#include "topology_builder.h"
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+class TopologyGenerator {
+public:
+    explicit TopologyGenerator(const std::string& spec) : m_spec(spec) {
+        size_t colon = spec.find(':');
+        m_kind = spec.substr(0, colon);
+        if (colon != std::string::npos) {
+            std::stringstream list(spec.substr(colon + 1));
+            for (std::string entry; std::getline(list, entry, ',');) {
+                size_t eq = entry.find('=');
+                NS_ABORT_MSG_IF(eq == std::string::npos, "Bad topology parameter '" << entry << "' in " << spec);
+                m_params[entry.substr(0, eq)] = entry.substr(eq + 1);
+            }
+        }
+    }
+
+    // Replaces the node lists and the link table with the generated network
+    void Generate(std::vector<std::string>& hostNames, std::vector<std::string>& routerNames,
+                  std::vector<LinkSpec>& links) {
+        m_core.clear();
+        m_hostRouter.clear();
+        uint32_t routers = 0;
+        uint32_t hostsPerRouter = ParamInt("hosts", 1);
+        if (m_kind == "ring") {
+            routers = ParamInt("routers", 16);
+            for (uint32_t i = 0; routers > 2 && i < routers; ++i) {
+                m_core.emplace_back(i, (i + 1) % routers);
+            }
+            if (routers == 2) {
+                m_core.emplace_back(0, 1);
+            }
+        } else if (m_kind == "grid") {
+            uint32_t width = ParamInt("width", 4);
+            uint32_t height = ParamInt("height", width);
+            routers = width * height;
+            for (uint32_t y = 0; y < height; ++y) {
+                for (uint32_t x = 0; x < width; ++x) {
+                    if (x + 1 < width) {
+                        m_core.emplace_back(y * width + x, y * width + x + 1);
+                    }
+                    if (y + 1 < height) {
+                        m_core.emplace_back(y * width + x, (y + 1) * width + x);
+                    }
+                }
+            }
+        } else if (m_kind == "waxman") {
+            routers = ParamInt("routers", 100);
+            Waxman(routers, ParamDouble("alpha", 0.15), ParamDouble("beta", 0.2));
+        } else if (m_kind == "fattree") {
+            uint32_t k = ParamInt("k", 4);
+            NS_ABORT_MSG_IF(k < 2 || k % 2, "Fat-tree arity must be even, got " << k);
+            routers = FatTree(k);
+            hostsPerRouter = 0;   // attached to the edge switches by FatTree()
+        } else if (m_kind == "edges") {
+            routers = EdgeList(ParamString("file"));
+        } else {
+            NS_ABORT_MSG("Unknown topology kind '" << m_kind << "' in " << m_spec);
+        }
+
+        std::string hostRate = ParamString("hostRate", "1Mbps");
+        std::string coreRate = ParamString("coreRate", "2Mbps");
+        std::string delay = ParamString("delay", "2ms");
+        if (hostsPerRouter) {
+            for (uint32_t r = 0; r < routers; ++r) {
+                m_hostRouter.insert(m_hostRouter.end(), hostsPerRouter, r);
+            }
+        }
+
+        hostNames.clear();
+        routerNames.clear();
+        links.clear();
+        hostNames.reserve(m_hostRouter.size());
+        routerNames.reserve(routers);
+        links.reserve(m_hostRouter.size() + m_core.size());
+        for (uint32_t h = 0; h < m_hostRouter.size(); ++h) {
+            hostNames.push_back("H" + std::to_string(h));
+        }
+        for (uint32_t r = 0; r < routers; ++r) {
+            routerNames.push_back("R" + std::to_string(r));
+        }
+        for (uint32_t h = 0; h < m_hostRouter.size(); ++h) {
+            links.push_back({hostNames[h], routerNames[m_hostRouter[h]], hostRate, delay, ""});
+        }
+        for (const auto& edge : m_core) {
+            links.push_back({routerNames[edge.first], routerNames[edge.second], coreRate, delay, ""});
+        }
+    }
+
+private:
+    uint32_t ParamInt(const std::string& key, uint32_t fallback) const {
+        auto it = m_params.find(key);
+        return it == m_params.end() ? fallback : std::stoul(it->second);
+    }
+
+    double ParamDouble(const std::string& key, double fallback) const {
+        auto it = m_params.find(key);
+        return it == m_params.end() ? fallback : std::stod(it->second);
+    }
+
+    std::string ParamString(const std::string& key, const char* fallback = nullptr) const {
+        auto it = m_params.find(key);
+        NS_ABORT_MSG_IF(it == m_params.end() && !fallback, "Topology " << m_spec << " needs " << key << "=");
+        return it == m_params.end() ? fallback : it->second;
+    }
+
+    void Waxman(uint32_t n, double alpha, double beta) {
+        CounterRng rng(RngSeedManager::GetSeed(), RngSeedManager::GetRun(), kWaxmanStream);
+        std::vector<double> x(n);
+        std::vector<double> y(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            x[i] = rng.Uniform(2 * uint64_t(i));
+            y[i] = rng.Uniform(2 * uint64_t(i) + 1);
+        }
+        // Pair draws start past the coordinates' counters
+        const double scale = alpha * std::sqrt(2.0);
+        uint64_t counter = 2 * uint64_t(n);
+        std::vector<uint32_t> component(n);
+        std::iota(component.begin(), component.end(), 0);
+        for (uint32_t i = 0; i < n; ++i) {
+            for (uint32_t j = i + 1; j < n; ++j, ++counter) {
+                double d = std::hypot(x[i] - x[j], y[i] - y[j]);
+                if (rng.Uniform(counter) < beta * std::exp(-d / scale)) {
+                    m_core.emplace_back(i, j);
+                    component[Find(component, i)] = Find(component, j);
+                }
+            }
+        }
+        uint32_t previous = n;
+        for (uint32_t i = 0; i < n; ++i) {
+            if (Find(component, i) == i) {
+                if (previous != n) {
+                    m_core.emplace_back(previous, i);
+                }
+                previous = i;
+            }
+        }
+    }
+
+    static uint32_t Find(std::vector<uint32_t>& parent, uint32_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    // Routers are numbered core, then per pod its aggregation and edge switches
+    uint32_t FatTree(uint32_t k) {
+        uint32_t half = k / 2;
+        uint32_t cores = half * half;
+        for (uint32_t pod = 0; pod < k; ++pod) {
+            uint32_t agg = cores + pod * k;
+            uint32_t edge = agg + half;
+            for (uint32_t a = 0; a < half; ++a) {
+                for (uint32_t c = 0; c < half; ++c) {
+                    m_core.emplace_back(a * half + c, agg + a);
+                }
+                for (uint32_t e = 0; e < half; ++e) {
+                    m_core.emplace_back(agg + a, edge + e);
+                }
+            }
+            for (uint32_t e = 0; e < half; ++e) {
+                m_hostRouter.insert(m_hostRouter.end(), half, edge + e);
+            }
+        }
+        return cores + k * k;
+    }
+
+    uint32_t EdgeList(const std::string& path) {
+        std::ifstream file(path);
+        NS_ABORT_MSG_IF(!file.is_open(), "Cannot open edge list " << path);
+        std::unordered_map<std::string, uint32_t> ids;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line.substr(0, line.find('#')));
+            std::string u;
+            std::string v;
+            if (!(fields >> u)) {
+                continue;
+            }
+            NS_ABORT_MSG_IF(!(fields >> v), "Bad edge list line in " << path << ": '" << line << "'");
+            uint32_t a = ids.emplace(u, ids.size()).first->second;
+            uint32_t b = ids.emplace(v, ids.size()).first->second;
+            if (a != b) {
+                m_core.emplace_back(a, b);
+            }
+        }
+        return ids.size();
+    }
+
+    static constexpr uint64_t kWaxmanStream = 2000;
+
+    std::string m_spec;
+    std::string m_kind;
+    std::map<std::string, std::string> m_params;
+    std::vector<std::pair<uint32_t, uint32_t>> m_core;   // router-router links
+    std::vector<uint32_t> m_hostRouter;                  // host -> its router
+};
+
+// Shorthand for the experiments' --Topology option
+inline void GenerateTopology(const std::string& spec, std::vector<std::string>& hostNames,
+                             std::vector<std::string>& routerNames, std::vector<LinkSpec>& links) {
+    TopologyGenerator(spec).Generate(hostNames, routerNames, links);
+}
+
+#endif // TOPOLOGY_GENERATOR_H
@@ -4,113 +4,170 @@
 #include "ns3/internet-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/flow-monitor-module.h"
+#include "topology_builder.h"
+#include "topology_generator.h"
+#include "experiment_options.h"
+#include "run_profiler.h"
+#include "incremental_router.h"
+#include "error_models.h"
+#include "packet_trace_writer.h"
+#include "async_trace_sink.h"
+#include "path_tracker.h"
+#include "edge_flow_monitor.h"
 #include <fstream>
 #include <iomanip>
 #include <map>
 
 using namespace ns3;
 
-// Global variables for trace file
-std::ofstream traceFile;
+// Global binary trace writer, fed from the callback through an asynchronous
+// sink; decode with packet_trace_decoder
+PacketTraceWriter traceWriter;
+AsyncTraceSink<PacketTraceRecord> traceSink;
 
 // Function for logging packet traces
 void PacketTrace(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface) {
+    ++TraceCallbackCount();
     Ipv4Header ipv4Header;
     packet->PeekHeader(ipv4Header); // Extract IPv4 header
 
-    // Extract source and destination addresses
-    Ipv4Address source = ipv4Header.GetSource();
-    Ipv4Address destination = ipv4Header.GetDestination();
-
-    traceFile << Simulator::Now().GetSeconds() << " Packet " << packet->GetUid()
-              << " at Node " << ipv4->GetObject<Node>()->GetId()
-              << " on Interface " << interface
-              << " Source: " << source
-              << " Destination: " << destination
-              << std::endl;
+    PacketTraceRecord record;
+    record.timeNs = Simulator::Now().GetNanoSeconds();
+    record.uid = packet->GetUid();
+    record.node = ipv4->GetObject<Node>()->GetId();
+    record.iface = interface;
+    record.src = ipv4Header.GetSource().Get();
+    record.dst = ipv4Header.GetDestination().Get();
+    traceSink.Push(record);
 }
 
 int main(int argc, char *argv[]) {
+    ExperimentOptions options;
+    options.errorRate = 0.0;
+    options.maxPackets = 100;
+    options.stopTime = 10.0;
+    bool writeTraces = true;
+    bool fullFlowMonitor = false;
+    uint32_t flowSample = 0;
+    bool echoPairs = false;
     CommandLine cmd;
-    cmd.Parse(argc, argv);
+    AddExperimentOptions(cmd, options);
+    cmd.AddValue("WriteTraces", "Also write the per-packet binary trace (packet-traces.bin)", writeTraces);
+    cmd.AddValue("FullFlowMonitor", "Install FlowMonitor on every node and write flow-monitor.xml instead of "
+                 "the host-only flow_stats.csv", fullFlowMonitor);
+    cmd.AddValue("FlowSample", "Put every Nth packet of each flow in its delay histogram (0: no histograms)",
+                 flowSample);
+    cmd.AddValue("EchoPairs", "Every host echoes with the host half way round the host list instead of only "
+                 "B with A", echoPairs);
+    ParseExperimentOptions(cmd, options, argc, argv);
 
     Time::SetResolution(Time::NS);
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
-
-    LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
-    LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
 
-    // Create 7 hosts (A-G) and 4 routers (R1-R4)
-    NodeContainer hosts;
-    hosts.Create(7);
-    NodeContainer routers;
-    routers.Create(4);
+    if (options.logPackets) {
+        LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
+        LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
+    }
 
-    InternetStackHelper stack;
-    stack.Install(hosts);
-    stack.Install(routers);
-
-    // Point-to-point links
-    PointToPointHelper p2p;
-    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps"));
-
-    // Host-router connections
-    NetDeviceContainer hostDevices[7];
-    hostDevices[0] = p2p.Install(NodeContainer(hosts.Get(0), routers.Get(0))); // A - R1
-    hostDevices[1] = p2p.Install(NodeContainer(hosts.Get(1), routers.Get(0))); // B - R1
-    hostDevices[2] = p2p.Install(NodeContainer(hosts.Get(2), routers.Get(2))); // C - R3
-    hostDevices[3] = p2p.Install(NodeContainer(hosts.Get(3), routers.Get(2))); // D - R3
-    hostDevices[4] = p2p.Install(NodeContainer(hosts.Get(4), routers.Get(1))); // E - R2
-    hostDevices[5] = p2p.Install(NodeContainer(hosts.Get(5), routers.Get(1))); // F - R2
-    hostDevices[6] = p2p.Install(NodeContainer(hosts.Get(6), routers.Get(3))); // G - R4
-
-    // Router-router connections
-    NetDeviceContainer routerDevices;
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(0), routers.Get(1)))); // R1 - R2
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(0), routers.Get(2)))); // R1 - R3
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(2), routers.Get(3)))); // R3 - R4
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(1), routers.Get(3)))); // R2 - R4
-
-    // Assign IP addresses
-    Ipv4AddressHelper address;
-    address.SetBase("10.1.0.0", "255.255.255.0");
-    for (uint32_t i = 0; i < 7; ++i) {
-        address.Assign(hostDevices[i]);
+    // Same A-G / R1-R4 network with every link at 1Mbps
+    std::vector<std::string> hostNames = DefaultHostNames();
+    std::vector<std::string> routerNames = DefaultRouterNames();
+    std::vector<LinkSpec> links = DefaultLinkTable();
+    for (auto& link : links) {
+        link.dataRate = "1Mbps";
+    }
+    if (!options.linkTable.empty()) {
+        LoadLinkTable(options.linkTable, hostNames, routerNames, links);
     }
-    address.SetBase("10.1.1.0", "255.255.255.0");
-    for (uint32_t i = 0; i < routerDevices.GetN(); ++i) {
-        address.Assign(routerDevices.Get(i));
+    if (!options.topology.empty()) {
+        GenerateTopology(options.topology, hostNames, routerNames, links);
     }
+    InternetStackHelper stack;
+    Topology topo = BuildTopology(hostNames, routerNames, links, stack, ExperimentAddressPlan(options));
+    NodeContainer hosts = topo.hosts;
+
+    // An independent error model per link, from the link table's loss column
+    // (ErrorRate on links without one), each on its own RNG streams
+    InstallErrorModels(topo, options.errorRate);
+
+    // Global routing, or the incremental router when links fail during the run
+    std::unique_ptr<IncrementalRouter> router = SetUpRouting(topo, options.linkEvents);
 
     // Install applications
     UdpEchoServerHelper echoServer(9);
     ApplicationContainer serverApps = echoServer.Install(hosts);
     serverApps.Start(Seconds(1.0));
-    serverApps.Stop(Seconds(10.0));
-
-    UdpEchoClientHelper echoClient(Ipv4Address("10.1.0.1"), 9);
-    echoClient.SetAttribute("MaxPackets", UintegerValue(100));
-    echoClient.SetAttribute("Interval", TimeValue(Seconds(0.01)));
-    echoClient.SetAttribute("PacketSize", UintegerValue(1024));
-    ApplicationContainer clientApps = echoClient.Install(hosts.Get(1));
+    serverApps.Stop(Seconds(options.appStopTime));
+
+    // Host B echoes with host A, or with EchoPairs every host i with host
+    // i + N/2, so the traced paths grow with the network
+    uint32_t n = hosts.GetN();
+    ApplicationContainer clientApps;
+    for (uint32_t i = echoPairs ? 0 : 1; i < (echoPairs ? n : 2); ++i) {
+        uint32_t peer = echoPairs ? (i + n / 2) % n : 0;
+        if (peer == i) {
+            continue;
+        }
+        UdpEchoClientHelper echoClient(topo.HostAddress(peer), 9);
+        echoClient.SetAttribute("MaxPackets", UintegerValue(options.maxPackets));
+        echoClient.SetAttribute("Interval", TimeValue(Seconds(options.interval)));
+        echoClient.SetAttribute("PacketSize", UintegerValue(options.packetSize));
+        clientApps.Add(echoClient.Install(hosts.Get(i)));
+    }
     clientApps.Start(Seconds(2.0));
-    clientApps.Stop(Seconds(10.0));
+    clientApps.Stop(Seconds(options.appStopTime));
 
-    // Set up FlowMonitor
+    // End-to-end flow statistics from the hosts alone, or the full per-hop FlowMonitor
     FlowMonitorHelper flowHelper;
-    Ptr<FlowMonitor> flowMonitor = flowHelper.InstallAll();
+    Ptr<FlowMonitor> flowMonitor;
+    std::unique_ptr<EdgeFlowMonitor> edgeMonitor;
+    if (fullFlowMonitor) {
+        flowMonitor = flowHelper.InstallAll();
+    } else {
+        edgeMonitor.reset(new EdgeFlowMonitor(topo, flowSample));
+    }
+
+    // Paths are rebuilt in memory as packets move, without reparsing the traces
+    PathTracker pathTracker(topo);
 
     // Open trace file and configure trace logging
-    traceFile.open("packet-traces.txt");
-    Config::ConnectWithoutContext("/NodeList/*/$ns3::Ipv4L3Protocol/Rx",
-                                  MakeCallback(&PacketTrace));
+    if (writeTraces) {
+        if (!traceWriter.Open(options.outputDir + "/packet-traces.bin")) {
+            std::cerr << "Error: Could not open " << options.outputDir << "/packet-traces.bin for writing!" << std::endl;
+            return 1;
+        }
+        // The sink's thread owns traceWriter from here until traceSink.Stop()
+        traceSink.Start([](const PacketTraceRecord* records, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                traceWriter.Write(records[i]);
+            }
+        });
+        traceSink.StopOnDestroy();
+        Config::ConnectWithoutContext("/NodeList/*/$ns3::Ipv4L3Protocol/Rx",
+                                      MakeCallback(&PacketTrace));
+    }
 
-    Simulator::Stop(Seconds(10.0));
+    Simulator::Stop(Seconds(options.stopTime));
+    RunProfiler profiler(topo, options.profile);
     Simulator::Run();
+    profiler.Finish(std::cout);
+    if (router && !router->WriteLinkChanges(options.outputDir + "/link_changes.txt")) {
+        std::cerr << "Error writing link_changes.txt!" << std::endl;
+    }
 
-    flowMonitor->SerializeToXmlFile("flow-monitor.xml", true, true);
-    traceFile.close();
+    if (flowMonitor) {
+        flowMonitor->SerializeToXmlFile(options.outputDir + "/flow-monitor.xml", true, true);
+    } else if (!edgeMonitor->WriteCsv(options.outputDir + "/flow_stats.csv") ||
+               !edgeMonitor->WriteHistogramCsv(options.outputDir + "/flow_histogram.csv")) {
+        std::cerr << "Error: Could not write the flow statistics!" << std::endl;
+    }
+    pathTracker.Finish();
+    if (!pathTracker.WriteReport(options.outputDir + "/paths.txt", options.outputDir + "/paths.csv")) {
+        std::cerr << "Error: Could not write the path report!" << std::endl;
+    }
+    if (writeTraces) {
+        traceSink.Stop();
+        traceWriter.Close();
+    }
     Simulator::Destroy();
 
     return 0;
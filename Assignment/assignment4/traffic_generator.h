@@ -0,0 +1,219 @@
+#ifndef TRAFFIC_GENERATOR_H
+#define TRAFFIC_GENERATOR_H
+
+// Turns a traffic matrix into UDP load. Each host runs one MatrixTrafficApp
+// that sends to every destination in its matrix row as a Poisson process of
+// rate load * packetsPerUnit packets/s. The per-destination processes are
+// merged into one: the host draws exponential gaps at the row's total rate and
+// picks the destination of each packet in proportion to its share, so a host
+// has a single pending send event however many peers it talks to. Every
+// packet carries a SeqTsSizeHeader with its send time (see delay_probe.h).
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "distributed.h"
+#include "topology_builder.h"
+#include "traffic_matrix.h"
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+class MatrixTrafficApp : public Application {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("MatrixTrafficApp")
+                                .SetParent<Application>()
+                                .AddConstructor<MatrixTrafficApp>()
+                                .AddTraceSource("Tx", "A packet was handed to the socket",
+                                                MakeTraceSourceAccessor(&MatrixTrafficApp::m_txTrace),
+                                                "ns3::Packet::TracedCallback");
+        return tid;
+    }
+
+    // 'ratesPps[i]' is the packet rate towards 'destinations[i]'
+    void Setup(const std::vector<Ipv4Address>& destinations, const std::vector<double>& ratesPps,
+               uint16_t port, uint32_t packetSize) {
+        m_destinations.clear();
+        m_cumulative.clear();
+        m_totalRate = 0;
+        for (size_t i = 0; i < destinations.size(); ++i) {
+            if (ratesPps[i] > 0) {
+                m_totalRate += ratesPps[i];
+                m_destinations.push_back(destinations[i]);
+                m_cumulative.push_back(m_totalRate);
+            }
+        }
+        m_sent.assign(m_destinations.size(), 0);
+        m_port = port;
+        m_packetSize = packetSize;
+    }
+
+    static const int64_t kStreams = 2;
+
+    int64_t AssignStreams(int64_t stream) {
+        m_gap->SetStream(stream);
+        m_pick->SetStream(stream + 1);
+        return kStreams;
+    }
+
+    uint64_t GetTotalSent() const {
+        uint64_t total = 0;
+        for (uint64_t sent : m_sent) {
+            total += sent;
+        }
+        return total;
+    }
+
+private:
+    void StartApplication() override {
+        if (m_totalRate <= 0) {
+            return;
+        }
+        m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+        m_socket->Bind();
+        m_gap->SetAttribute("Mean", DoubleValue(1.0 / m_totalRate));
+        ScheduleNext();
+    }
+
+    void StopApplication() override {
+        Simulator::Cancel(m_sendEvent);
+        if (m_socket) {
+            m_socket->Close();
+            m_socket = nullptr;
+        }
+    }
+
+    void ScheduleNext() {
+        m_sendEvent = Simulator::Schedule(Seconds(m_gap->GetValue()), &MatrixTrafficApp::Send, this);
+    }
+
+    void Send() {
+        double u = m_pick->GetValue(0, m_totalRate);
+        size_t i = std::upper_bound(m_cumulative.begin(), m_cumulative.end(), u) - m_cumulative.begin();
+        i = std::min(i, m_cumulative.size() - 1);
+        SeqTsSizeHeader header;
+        header.SetSeq(m_seq++);
+        header.SetSize(m_packetSize);
+        Ptr<Packet> packet = Create<Packet>(m_packetSize - std::min(m_packetSize, header.GetSerializedSize()));
+        packet->AddHeader(header);
+        m_txTrace(packet);
+        m_socket->SendTo(packet, 0, InetSocketAddress(m_destinations[i], m_port));
+        ++m_sent[i];
+        ScheduleNext();
+    }
+
+    std::vector<Ipv4Address> m_destinations;
+    std::vector<double> m_cumulative;   // running sum of the destination rates
+    std::vector<uint64_t> m_sent;
+    double m_totalRate = 0;
+    uint16_t m_port = 9;
+    uint32_t m_packetSize = 1024;
+    uint32_t m_seq = 0;
+    Ptr<Socket> m_socket;
+    EventId m_sendEvent;
+    TracedCallback<Ptr<const Packet>> m_txTrace;
+    Ptr<ExponentialRandomVariable> m_gap = CreateObject<ExponentialRandomVariable>();
+    Ptr<UniformRandomVariable> m_pick = CreateObject<UniformRandomVariable>();
+};
+
+// Matrix with the same load on every off-diagonal pair
+inline TrafficMatrix UniformTrafficMatrix(const std::vector<std::string>& hostNames, uint32_t load) {
+    TrafficMatrix matrix(hostNames);
+    for (uint32_t i = 0; i < matrix.GetN(); ++i) {
+        for (uint32_t j = 0; j < matrix.GetN(); ++j) {
+            if (i != j) {
+                matrix.At(i, j) = load;
+            }
+        }
+    }
+    return matrix;
+}
+
+// Fixed-degree matrix: host i sends 'load' to each of hosts i+1 .. i+peers
+// (mod N), so the total load grows with N rather than N^2. 'peers' 0 or
+// >= N-1 gives the uniform matrix.
+inline TrafficMatrix PeerTrafficMatrix(const std::vector<std::string>& hostNames, uint32_t peers, uint32_t load) {
+    uint32_t n = hostNames.size();
+    if (peers == 0 || peers + 1 >= n) {
+        return UniformTrafficMatrix(hostNames, load);
+    }
+    TrafficMatrix matrix(hostNames);
+    for (uint32_t i = 0; i < n; ++i) {
+        for (uint32_t k = 1; k <= peers; ++k) {
+            matrix.At(i, (i + k) % n) = load;
+        }
+    }
+    return matrix;
+}
+
+// Only the rows of the sources in 'group' of 'groups' (source i is in group
+// i % groups), to run groups of sources in isolation
+inline TrafficMatrix SourceGroup(const TrafficMatrix& matrix, uint32_t group, uint32_t groups) {
+    TrafficMatrix rows(matrix.GetLabels());
+    for (uint32_t i = group; i < matrix.GetN(); i += groups) {
+        for (uint32_t j = 0; j < matrix.GetN(); ++j) {
+            rows.At(i, j) = matrix.At(i, j);
+        }
+    }
+    return rows;
+}
+
+// Installs a PacketSink on every host and one MatrixTrafficApp per host whose
+// matrix row has any load. Returns the sender apps, in host order. With
+// 'stream' >= 0 the senders use fixed RNG streams from 'stream' on, so their
+// arrivals do not shift when other objects are created first; host i's
+// sender always gets the streams from stream + i * kStreams on, whichever
+// rows have load. In a distributed run only the rank's own hosts get
+// applications, with the same streams they would have in a single process.
+inline ApplicationContainer InstallMatrixTraffic(const Topology& topo, const TrafficMatrix& matrix,
+                                                 double packetsPerUnit, uint32_t packetSize, uint16_t port,
+                                                 Time start, Time stop, int64_t stream = -1) {
+    PacketSinkHelper sink("ns3::UdpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), port));
+    sink.SetAttribute("EnableSeqTsSizeHeader", BooleanValue(true));
+    NodeContainer localHosts;
+    for (uint32_t i = 0; i < topo.GetNHosts(); ++i) {
+        if (IsLocalNode(topo.hosts.Get(i))) {
+            localHosts.Add(topo.hosts.Get(i));
+        }
+    }
+    ApplicationContainer sinks = sink.Install(localHosts);
+    sinks.Start(Seconds(0));
+    sinks.Stop(stop);
+
+    std::vector<Ipv4Address> destinations;
+    for (uint32_t j = 0; j < topo.GetNHosts(); ++j) {
+        destinations.push_back(topo.HostAddress(j));
+    }
+    ApplicationContainer senders;
+    for (uint32_t i = 0; i < topo.GetNHosts() && i < matrix.GetN(); ++i) {
+        std::vector<double> rates(destinations.size(), 0.0);
+        bool any = false;
+        for (uint32_t j = 0; j < rates.size() && j < matrix.GetN(); ++j) {
+            if (i != j) {
+                rates[j] = matrix.At(i, j) * packetsPerUnit;
+                any = any || rates[j] > 0;
+            }
+        }
+        if (!any) {
+            continue;
+        }
+        Ptr<MatrixTrafficApp> app = CreateObject<MatrixTrafficApp>();
+        app->Setup(destinations, rates, port, packetSize);
+        if (stream >= 0) {
+            app->AssignStreams(stream + int64_t(i) * MatrixTrafficApp::kStreams);
+        }
+        if (!IsLocalNode(topo.hosts.Get(i))) {
+            continue;
+        }
+        topo.hosts.Get(i)->AddApplication(app);
+        senders.Add(app);
+    }
+    senders.Start(start);
+    senders.Stop(stop);
+    return senders;
+}
+
+#endif // TRAFFIC_GENERATOR_H
@@ -0,0 +1,175 @@
+#ifndef TRAFFIC_MATRIX_H
+#define TRAFFIC_MATRIX_H
+
+// Dense N x N matrix indexed by node index (row = source, column = destination)
+// and stored row-major in one contiguous buffer. Plain C++, no ns-3, so the
+// binary files can be read back by offline tools.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class DenseMatrix {
+    static_assert(std::is_arithmetic<T>::value, "DenseMatrix holds plain numbers");
+
+public:
+    DenseMatrix() = default;
+
+    explicit DenseMatrix(const std::vector<std::string>& labels)
+        : m_labels(labels), m_n(labels.size()), m_data(labels.size() * labels.size(), T()) {
+        m_index.reserve(m_n);
+        for (uint32_t i = 0; i < m_n; ++i) {
+            m_index[m_labels[i]] = i;
+        }
+    }
+
+    uint32_t GetN() const { return m_n; }
+    const std::vector<std::string>& GetLabels() const { return m_labels; }
+
+    // Row/column of 'label', or -1 if it is not in the matrix
+    int64_t IndexOf(const std::string& label) const {
+        auto it = m_index.find(label);
+        return it != m_index.end() ? int64_t(it->second) : -1;
+    }
+
+    T& At(uint32_t src, uint32_t dst) { return m_data[size_t(src) * m_n + dst]; }
+    const T& At(uint32_t src, uint32_t dst) const { return m_data[size_t(src) * m_n + dst]; }
+
+    void Increment(uint32_t src, uint32_t dst, T by = T(1)) { m_data[size_t(src) * m_n + dst] += by; }
+
+    void Fill(T value) { std::fill(m_data.begin(), m_data.end(), value); }
+
+    // Element-wise sum, e.g. to merge the matrices of several runs
+    void Add(const DenseMatrix& other) {
+        for (size_t i = 0; i < m_data.size() && i < other.m_data.size(); ++i) {
+            m_data[i] += other.m_data[i];
+        }
+    }
+
+    T* Data() { return m_data.data(); }
+    const T* Data() const { return m_data.data(); }
+
+    // Labelled table: 'title' on its own line, then a header row that starts
+    // with 'corner', every cell right-aligned in 'width' and followed by 'sep'.
+    void WriteText(std::ostream& os, const std::string& title, const std::string& corner,
+                   int width, const std::string& sep) const {
+        os << title << "\n";
+        os << std::setw(width) << corner << sep;
+        for (const auto& label : m_labels) {
+            os << std::setw(width) << label << sep;
+        }
+        os << "\n";
+        for (uint32_t i = 0; i < m_n; ++i) {
+            os << std::setw(width) << m_labels[i] << sep;
+            for (uint32_t j = 0; j < m_n; ++j) {
+                os << std::setw(width) << At(i, j) << sep;
+            }
+            os << "\n";
+        }
+    }
+
+    // One "src,dst,<valueName>" row per off-diagonal pair
+    bool WriteCsv(const std::string& path, const std::string& valueName) const {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << std::setprecision(9) << "src,dst," << valueName << "\n";
+        for (uint32_t i = 0; i < m_n; ++i) {
+            for (uint32_t j = 0; j < m_n; ++j) {
+                if (i != j) {
+                    file << m_labels[i] << "," << m_labels[j] << "," << At(i, j) << "\n";
+                }
+            }
+        }
+        return file.good();
+    }
+
+    // The bare n * n values, and adding such a dump into this matrix, e.g. to
+    // collect the results of several processes
+    void WriteRaw(std::ostream& os) const {
+        os.write(reinterpret_cast<const char*>(m_data.data()), m_data.size() * sizeof(T));
+    }
+
+    bool AddRaw(std::istream& is) {
+        std::vector<T> values(m_data.size());
+        if (!is.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T))) {
+            return false;
+        }
+        for (size_t i = 0; i < values.size(); ++i) {
+            m_data[i] += values[i];
+        }
+        return true;
+    }
+
+    // Layout: "DMATRIX1", uint32 n, uint32 sizeof(T), then n labels as
+    // uint32 length + bytes, then the n * n values; all in host byte order.
+    bool WriteBinary(const std::string& path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        uint32_t elementSize = sizeof(T);
+        file.write(kMagic, 8);
+        file.write(reinterpret_cast<const char*>(&m_n), sizeof(m_n));
+        file.write(reinterpret_cast<const char*>(&elementSize), sizeof(elementSize));
+        for (const auto& label : m_labels) {
+            uint32_t length = label.size();
+            file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            file.write(label.data(), length);
+        }
+        file.write(reinterpret_cast<const char*>(m_data.data()), m_data.size() * sizeof(T));
+        return file.good();
+    }
+
+    bool ReadBinary(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        char magic[8];
+        uint32_t n = 0;
+        uint32_t elementSize = 0;
+        if (!file.read(magic, 8) || std::memcmp(magic, kMagic, 8) != 0 ||
+            !file.read(reinterpret_cast<char*>(&n), sizeof(n)) ||
+            !file.read(reinterpret_cast<char*>(&elementSize), sizeof(elementSize)) || elementSize != sizeof(T)) {
+            return false;
+        }
+        std::vector<std::string> labels(n);
+        for (auto& label : labels) {
+            uint32_t length = 0;
+            if (!file.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+                return false;
+            }
+            label.resize(length);
+            if (!file.read(&label[0], length)) {
+                return false;
+            }
+        }
+        DenseMatrix matrix(labels);
+        if (!file.read(reinterpret_cast<char*>(matrix.m_data.data()), matrix.m_data.size() * sizeof(T))) {
+            return false;
+        }
+        *this = std::move(matrix);
+        return true;
+    }
+
+private:
+    static constexpr const char* kMagic = "DMATRIX1";
+
+    std::vector<std::string> m_labels;
+    std::unordered_map<std::string, uint32_t> m_index;
+    uint32_t m_n = 0;
+    std::vector<T> m_data;
+};
+
+typedef DenseMatrix<uint32_t> TrafficMatrix;
+
+#endif // TRAFFIC_MATRIX_H
@@ -8,6 +8,15 @@
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/error-model.h" 
+#include "topology_builder.h"
+#include "topology_generator.h"
+#include "ip_node_map.h"
+#include "experiment_options.h"
+#include "run_profiler.h"
+#include "incremental_router.h"
+#include "error_models.h"
+#include "traffic_generator.h"
+#include "traffic_matrix.h"
 #include <map>
 #include <utility>
 #include <string>
@@ -16,14 +25,12 @@
 #include <fstream>
 #include <iomanip>
 #include "ns3/flow-monitor-module.h"
-#include <iomanip>
 
 using namespace ns3;
 
 
 // Declare the traffic matrix
-std::map<std::pair<std::string, std::string>, uint32_t> trafficMatrix;
-std::map<Ipv4Address, std::string> ipToNodeName;
+TrafficMatrix trafficMatrix;
 NS_LOG_COMPONENT_DEFINE("CustomNetworkSimulation");
 
 
@@ -31,150 +38,75 @@ NS_LOG_COMPONENT_DEFINE("CustomNetworkSimulation");
 
 int main(int argc, char *argv[]) {
 
+    ExperimentOptions options;
     CommandLine cmd;
-    cmd.Parse(argc, argv);
+    AddExperimentOptions(cmd, options);
+    ParseExperimentOptions(cmd, options, argc, argv);
 
     Time::SetResolution(Time::NS);
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
     
 
     // Enable logging for debugging
-    LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
-    LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
-
-    // Create 7 hosts (A-G) and 4 routers (R1-R4)
-    NodeContainer hosts;
-    hosts.Create(7);
-    NodeContainer routers;
-    routers.Create(4);
-       std::vector<std::string> hostNames = {"A", "B", "C", "D", "E", "F", "G"};
-
-    InternetStackHelper stack;
-    Ipv4GlobalRoutingHelper globalRouting; // Ensure global routing is used
-stack.SetRoutingHelper(globalRouting);
-    stack.Install(hosts);
-    stack.Install(routers);
-
- PointToPointHelper p2p;
-
-    // Define link parameters based on the image topology
-    // Connect hosts to their respective routers
-    NetDeviceContainer hostDevices[7];
-    NetDeviceContainer routerDevices;
-    // Host-to-Router links with capacities from Table 3
-    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // A - R1
-    hostDevices[0] = p2p.Install(NodeContainer(hosts.Get(0), routers.Get(0)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // B - R1
-    hostDevices[1] = p2p.Install(NodeContainer(hosts.Get(1), routers.Get(0)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // C - R3
-    hostDevices[2] = p2p.Install(NodeContainer(hosts.Get(2), routers.Get(2)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("2Mbps")); // D - R3
-    hostDevices[3] = p2p.Install(NodeContainer(hosts.Get(3), routers.Get(2)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // E - R2
-    hostDevices[4] = p2p.Install(NodeContainer(hosts.Get(4), routers.Get(1)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // F - R2
-    hostDevices[5] = p2p.Install(NodeContainer(hosts.Get(5), routers.Get(1)));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // G - R4
-    hostDevices[6] = p2p.Install(NodeContainer(hosts.Get(6), routers.Get(3)));
-
-    // Router-to-Router links with capacities from Table 3
-    p2p.SetDeviceAttribute("DataRate", StringValue("3Mbps")); // R1 - R2
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(0), routers.Get(1))));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("2.5Mbps")); // R1 - R3
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(0), routers.Get(2))));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1.5Mbps")); // R3 - R4
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(2), routers.Get(3))));
-
-    p2p.SetDeviceAttribute("DataRate", StringValue("1Mbps")); // R2 - R4
-    routerDevices.Add(p2p.Install(NodeContainer(routers.Get(1), routers.Get(3))));
-
-    // Create an Error Model
-Ptr<RateErrorModel> errorModel = CreateObject<RateErrorModel>();
-errorModel->SetAttribute("ErrorRate", DoubleValue(0.01)); // 1% packet drop rate
+    if (options.logPackets) {
+        LogComponentEnable("PacketSink", LOG_LEVEL_INFO);
+    }
 
-// Apply the error model to each device
-for (uint32_t i = 0; i < 7; ++i) {
-        hostDevices[i].Get(1)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); 
+    // Build the 7-host / 4-router network (A-G, R1-R4) from the Table 3 link table
+    std::vector<std::string> hostNames = DefaultHostNames();
+    std::vector<std::string> routerNames = DefaultRouterNames();
+    std::vector<LinkSpec> links = DefaultLinkTable();
+    if (!options.linkTable.empty()) {
+        LoadLinkTable(options.linkTable, hostNames, routerNames, links);
     }
-    for (uint32_t i = 0; i < routerDevices.GetN(); ++i) {
-        routerDevices.Get(i)->SetAttribute("ReceiveErrorModel", PointerValue(errorModel)); 
+    if (!options.topology.empty()) {
+        GenerateTopology(options.topology, hostNames, routerNames, links);
     }
+    InternetStackHelper stack;
+    Topology topo = BuildTopology(hostNames, routerNames, links, stack, ExperimentAddressPlan(options));
+    NodeContainer hosts = topo.hosts;
 
-    // Assign IP addresses to all links
-    Ipv4AddressHelper address;
-    std::string baseIp = "10.1.";
-    for (uint32_t i = 0; i < 7; ++i) {
-        address.SetBase(Ipv4Address((baseIp + std::to_string(i) + ".0").c_str()), "255.255.255.0");
-        address.Assign(hostDevices[i]);
-    }
+    // An independent error model per link, from the link table's loss column
+    // (ErrorRate on links without one), each on its own RNG streams
+    InstallErrorModels(topo, options.errorRate);
 
-    for (uint32_t i = 0; i < routerDevices.GetN(); ++i) {
-        address.SetBase(Ipv4Address((baseIp + std::to_string(i + 7) + ".0").c_str()), "255.255.255.0");
-        address.Assign(routerDevices.Get(i));
-    }
+    // Every host sends to every other host (to the next Peers hosts with
+    // --Peers): Poisson arrivals averaging one packet per Interval per pair,
+    // for as long as MaxPackets packets take on average
+    InstallMatrixTraffic(topo, PeerTrafficMatrix(hostNames, options.peers, 1), 1.0 / options.interval,
+                         options.packetSize, 9, Seconds(2.0),
+                         Seconds(std::min(options.appStopTime, 2.0 + options.maxPackets * options.interval)), 0);
+
+    // Global routing, or the incremental router when links fail during the run
+    std::unique_ptr<IncrementalRouter> router = SetUpRouting(topo, options.linkEvents);
 
-    // Set up UDP Echo server on Host A (host 0)
-    UdpEchoServerHelper echoServer(9);
-    ApplicationContainer serverApps;
-    for (uint32_t i = 0; i < 7; ++i) {
-        ApplicationContainer serverApp = echoServer.Install(hosts.Get(i));
-        serverApps.Add(serverApp);
-    }
-    serverApps.Start(Seconds(1.0));
-    serverApps.Stop(Seconds(10.0));
-
-    // Enable global routing
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
-
-    // Set up UDP Echo clients on remaining hosts (B-G)
-    for (uint32_t i = 0; i < 7; ++i) {
-        for (uint32_t j = 0; j < 7; ++j) {
-            if (i != j) { // Avoid sending traffic to itself
-                
-                UdpEchoClientHelper echoClient(Ipv4Address(("10.1." + std::to_string(j) + ".1").c_str()), 9);
-
-                // UdpEchoClientHelper echoClient(Ipv4Address("10.1.0.1"), 9);
-                echoClient.SetAttribute("MaxPackets", UintegerValue(1000));
-                echoClient.SetAttribute("Interval", TimeValue(Seconds(0.01)));
-                echoClient.SetAttribute("PacketSize", UintegerValue(1024));
-
-                ApplicationContainer clientApps = echoClient.Install(hosts.Get(i));
-                clientApps.Start(Seconds(2.0 + i + j));
-                clientApps.Stop(Seconds(10.0));
-            }
-        }
-    }
     // Set up FlowMonitor
     Ptr<FlowMonitor> flowMonitor;
     FlowMonitorHelper flowHelper;
     flowMonitor = flowHelper.InstallAll();
 
-    // IP to Node Name Mapping
-    ipToNodeName[Ipv4Address("10.1.0.1")] = "A";
-    ipToNodeName[Ipv4Address("10.1.1.1")] = "B";
-    ipToNodeName[Ipv4Address("10.1.2.1")] = "C";
-    ipToNodeName[Ipv4Address("10.1.3.1")] = "D";
-    ipToNodeName[Ipv4Address("10.1.4.1")] = "E";
-    ipToNodeName[Ipv4Address("10.1.5.1")] = "F";
-    ipToNodeName[Ipv4Address("10.1.6.1")] = "G";
+    // IP to node mapping, from every interface address the stack holds
+    IpNodeMap ipToNode(topo);
 
     // Run the simulation
-    Simulator::Stop(Seconds(60.0));
+    Simulator::Stop(Seconds(options.stopTime));
+    RunProfiler profiler(topo, options.profile);
     Simulator::Run();
+    profiler.Finish(std::cout);
+    if (router && !router->WriteLinkChanges(options.outputDir + "/link_changes.txt")) {
+        std::cerr << "Error writing link_changes.txt!" << std::endl;
+    }
 
-    // Analyze the packet loss
+    // Analyze the packet loss: lost packets of every flow, by node name
     Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flowHelper.GetClassifier());
-
+    flowMonitor->CheckForLostPackets();
+    for (const auto& flow : flowMonitor->GetFlowStats()) {
+        Ipv4FlowClassifier::FiveTuple tuple = classifier->FindFlow(flow.first);
+        std::cout << "Flow from " << ipToNode.Name(tuple.sourceAddress) << " to "
+                  << ipToNode.Name(tuple.destinationAddress) << ": "
+                  << "Lost Packets = " << flow.second.lostPackets << ", "
+                  << "Tx Packets = " << flow.second.txPackets << ", "
+                  << "Rx Packets = " << flow.second.rxPackets << std::endl;
+    }
 
     // Clean up and exit
     Simulator::Destroy();